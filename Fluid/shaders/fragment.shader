@@ -1,10 +1,9 @@
 #version 430 core
 
-#define MAX_PARTICLES 5000
-
-layout(binding = 0, std140) uniform ParticlesBlock
+// tightly packed, positions are uploaded straight from the solver or a mapped trajectory
+layout(binding = 0, std430) readonly buffer ParticlesBlock
 {
-	vec2 particles[MAX_PARTICLES];
+	vec2 particles[];
 };
 
 uniform int particleCount;
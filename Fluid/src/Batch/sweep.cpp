@@ -0,0 +1,459 @@
+#include "sweep.hpp"
+#include "../Scene/scene.hpp"
+#include "../PBF/particles.hpp"
+#include "../PBF/activity.hpp"
+#include "../IISPH/iisph.hpp"
+#include "../IO/checkpoint.hpp"
+#include "../IO/stateCache.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using Clock = std::chrono::steady_clock;
+
+struct SweepAxis
+{
+	std::string section;
+	std::string key;
+	std::vector<std::string> values;
+};
+
+struct SweepSpec
+{
+	SceneConfig base = scene;
+	int frames = 600;
+	int jobs = 1;
+	int threads = 0;
+	std::string output = "sweep.csv";
+	std::vector<SweepAxis> axes;
+};
+
+enum class SweepStatus : int { Ok, Diverged, Invalid, Crashed };
+static const char* const statusNames[] = { "ok", "diverged", "invalid", "crashed" };
+
+// plain data, workers write it to their pipe or result file as is
+struct SweepResult
+{
+	SweepStatus status = SweepStatus::Crashed;
+	int    frames = 0;
+	double seconds = 0.0;
+	float  meanDensityError = 0.0f;	// both over |rho / rho0 - 1|, the sign is not kept
+	float  maxDensityError = 0.0f;
+	float  maxSpeed = 0.0f;
+	float  activeFraction = 0.0f;
+};
+
+static std::vector<std::string> splitValues(const std::string& text)
+{
+	std::vector<std::string> values;
+	size_t begin = 0;
+
+	while (begin <= text.size())
+	{
+		size_t end = text.find(',', begin);
+		if (end == std::string::npos) end = text.size();
+
+		const std::string value = text.substr(begin, end - begin);
+		const size_t first = value.find_first_not_of(" \t");
+		if (first != std::string::npos) values.push_back(value.substr(first, value.find_last_not_of(" \t") - first + 1));
+
+		begin = end + 1;
+	}
+	return values;
+}
+
+static bool parseSweep(const char* path, SweepSpec& spec)
+{
+	return parseIni(path, [&](const std::string& section, const std::string& key, const std::string& value, std::string& error)
+	{
+		if (section == "sweep")
+		{
+			char* end = nullptr;
+			const long number = std::strtol(value.c_str(), &end, 10);
+			const bool integer = end != value.c_str() && *end == '\0';
+
+			if (key == "base") return loadScene(value.c_str(), spec.base) || (error = "cannot use base scene " + value, false);
+			if (key == "output") { spec.output = value; return true; }
+			if (key == "frames" && integer && number > 0) { spec.frames = static_cast<int>(number); return true; }
+			if (key == "jobs" && integer && number > 0) { spec.jobs = static_cast<int>(number); return true; }
+			if (key == "threads" && integer && number > 0 && number <= threads) { spec.threads = static_cast<int>(number); return true; }
+
+			error = "invalid sweep setting " + key + " = " + value;
+			return false;
+		}
+		if (section == "vary")
+		{
+			const size_t dot = key.find('.');
+			SweepAxis axis = { key.substr(0, dot), dot == std::string::npos ? "" : key.substr(dot + 1), splitValues(value) };
+
+			// every value has to be accepted by the scene parser before anything runs
+			SceneConfig probe = spec.base;
+			for (const std::string& v : axis.values)
+			{
+				if (!setSceneValue(probe, axis.section, axis.key, v, error)) return false;
+			}
+			if (axis.values.empty())
+			{
+				error = "no values for " + key;
+				return false;
+			}
+			spec.axes.push_back(axis);
+			return true;
+		}
+
+		error = "unknown section [" + section + "]";
+		return false;
+	});
+}
+
+static int runCount(const SweepSpec& spec)
+{
+	int count = 1;
+	for (const SweepAxis& axis : spec.axes) count *= static_cast<int>(axis.values.size());
+	return count;
+}
+// the first axis varies fastest
+static std::vector<int> runValues(const SweepSpec& spec, int run)
+{
+	std::vector<int> values;
+	for (const SweepAxis& axis : spec.axes)
+	{
+		values.push_back(run % static_cast<int>(axis.values.size()));
+		run /= static_cast<int>(axis.values.size());
+	}
+	return values;
+}
+static bool runConfig(const SweepSpec& spec, const int& run, SceneConfig& config)
+{
+	config = spec.base;
+	config.trajectory = false;
+	config.threads = spec.threads;
+
+	const std::vector<int> values = runValues(spec, run);
+	std::string error;
+
+	for (size_t a = 0; a < spec.axes.size(); ++a)
+	{
+		setSceneValue(config, spec.axes[a].section, spec.axes[a].key, spec.axes[a].values[values[a]], error);
+	}
+	return validateScene(config, error);
+}
+
+static bool diverged()
+{
+	for (int i = 0; i < PARTICLES_NUMBER; ++i)
+	{
+		const vec2& p = particles.centers[i];
+		if (!(p.x == p.x && p.y == p.y)) return true;
+	}
+	return false;
+}
+
+static SweepResult runSimulation(const SceneConfig& config, const SweepSpec& spec, const char* initialState)
+{
+	SweepResult result;
+
+	scene = config;
+	if (!loadCheckpoint(initialState)) return result;
+	std::fill(stepSizes, stepSizes + PARTICLES_NUMBER, scene.dt);
+
+	result.status = SweepStatus::Ok;
+	const Clock::time_point start = Clock::now();
+
+	for (; result.frames < spec.frames; ++result.frames)
+	{
+		stepSimulation();
+
+		if (result.frames % 50 == 0 && diverged())
+		{
+			result.status = SweepStatus::Diverged;
+			break;
+		}
+	}
+	result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+	if (diverged()) result.status = SweepStatus::Diverged;
+
+	static const float restDensity = iisphRestDensity();
+	double sum = 0.0;
+
+	for (int i = 0; i < PARTICLES_NUMBER; ++i)
+	{
+		float error;
+		if constexpr (solver == Solver::IISPH) error = densities[i] / restDensity - 1.0f;
+		else error = densityErrors[i];
+
+		sum += glm::abs(error);
+		result.maxDensityError = Max(result.maxDensityError, glm::abs(error));
+		result.maxSpeed = Max(result.maxSpeed, glm::length(particles.dir[i]));
+	}
+	result.meanDensityError = static_cast<float>(sum / PARTICLES_NUMBER);
+	result.activeFraction = static_cast<float>(activeCount) / PARTICLES_NUMBER;
+
+	return result;
+}
+
+// Builds the initial state every run restores, settled and cached like the
+// viewer's. On POSIX it is built in a child process like the runs, the
+// solver opens parallel regions and the parent has to stay free of OpenMP
+// threads to fork safely.
+static bool writeInitialState(const SceneConfig& base, const char* path)
+{
+#ifndef _WIN32
+	const pid_t pid = fork();
+	if (pid == 0)
+	{
+		scene = base;
+		_exit(prepareInitialState() && saveCheckpoint(path) ? 0 : 1);
+	}
+
+	int status = 0;
+	return pid > 0 && waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+#else
+	scene = base;
+	return prepareInitialState() && saveCheckpoint(path);
+#endif
+}
+
+// Every run is a process of its own, the solver state lives in globals and
+// a fresh process is the only way to give each run its own copy. POSIX forks
+// the parent, which never opens a parallel region so every worker starts
+// with a fresh OpenMP runtime, and the result comes back through a pipe.
+// Windows starts the executable again with --sweep-worker appended to the
+// command line and the worker leaves its result in a file.
+struct SweepWorker
+{
+#ifdef _WIN32
+	HANDLE process;
+#else
+	pid_t pid;
+	int pipe;
+#endif
+	int run;
+};
+
+static std::string workerResultPath(const SweepSpec& spec, const int& run)
+{
+	return spec.output + ".run" + std::to_string(run);
+}
+
+static bool startWorker(const SweepSpec& spec, const SceneConfig& config, const int& run, const char* initialState, SweepWorker& worker)
+{
+#ifdef _WIN32
+	std::string command = std::string(GetCommandLineA()) + " --sweep-worker " + std::to_string(run);
+
+	STARTUPINFOA startup = {};
+	startup.cb = sizeof(startup);
+	PROCESS_INFORMATION info = {};
+
+	if (!CreateProcessA(nullptr, command.data(), nullptr, nullptr, FALSE, 0, nullptr, nullptr, &startup, &info)) return false;
+	CloseHandle(info.hThread);
+
+	worker = { info.hProcess, run };
+	return true;
+#else
+	int channel[2];
+	if (pipe(channel) != 0) return false;
+
+	const pid_t pid = fork();
+	if (pid == 0)
+	{
+		close(channel[0]);
+		const SweepResult result = runSimulation(config, spec, initialState);
+		const ssize_t written = write(channel[1], &result, sizeof(SweepResult));
+		_exit(written == sizeof(SweepResult) ? 0 : 1);
+	}
+
+	close(channel[1]);
+	if (pid < 0)
+	{
+		close(channel[0]);
+		return false;
+	}
+	worker = { pid, channel[0], run };
+	return true;
+#endif
+}
+
+// blocks until a worker exits, returns its position in workers or -1 when waiting fails
+static int collectWorker(const SweepSpec& spec, const std::vector<SweepWorker>& workers, SweepResult& result)
+{
+	result = SweepResult();
+
+#ifdef _WIN32
+	std::vector<HANDLE> handles;
+	for (const SweepWorker& w : workers) handles.push_back(w.process);
+
+	const DWORD signaled = WaitForMultipleObjects(static_cast<DWORD>(handles.size()), handles.data(), FALSE, INFINITE);
+	if (signaled >= WAIT_OBJECT_0 + handles.size()) return -1;
+
+	const int index = static_cast<int>(signaled - WAIT_OBJECT_0);
+	DWORD code = 1;
+	GetExitCodeProcess(workers[index].process, &code);
+	CloseHandle(workers[index].process);
+
+	const std::string path = workerResultPath(spec, workers[index].run);
+	{
+		std::ifstream file(path, std::ios::binary);
+		if (code != 0 || !file.read(reinterpret_cast<char*>(&result), sizeof(SweepResult))) result = SweepResult();
+	}
+	std::remove(path.c_str());
+	return index;
+#else
+	// the result is smaller than a pipe buffer, a worker never blocks on its write
+	for (;;)
+	{
+		int status = 0;
+		const pid_t done = waitpid(-1, &status, 0);
+		if (done < 0) return -1;
+
+		const auto worker = std::find_if(workers.begin(), workers.end(), [&](const SweepWorker& w) { return w.pid == done; });
+		if (worker == workers.end()) continue;
+
+		if (read(worker->pipe, &result, sizeof(SweepResult)) != sizeof(SweepResult)) result = SweepResult();
+		close(worker->pipe);
+		return static_cast<int>(worker - workers.begin());
+	}
+#endif
+}
+
+static void runWorkers(const SweepSpec& spec, const std::vector<SceneConfig>& configs, const std::vector<bool>& valid,
+	const char* initialState, std::vector<SweepResult>& results)
+{
+	std::vector<SweepWorker> workers;
+	int next = 0;
+	int finished = 0;
+
+	while (next < static_cast<int>(configs.size()) || !workers.empty())
+	{
+		while (static_cast<int>(workers.size()) < spec.jobs && next < static_cast<int>(configs.size()))
+		{
+			const int run = next++;
+			if (!valid[run]) continue;
+
+			SweepWorker worker;
+			if (startWorker(spec, configs[run], run, initialState, worker)) workers.push_back(worker);
+			else std::cerr << "sweep: cannot start run " << run << std::endl;
+		}
+		if (workers.empty()) continue;
+
+		SweepResult result;
+		const int done = collectWorker(spec, workers, result);
+		if (done < 0) break;
+
+		results[workers[done].run] = result;
+		std::cout << "sweep: run " << workers[done].run << " " << statusNames[static_cast<int>(result.status)]
+			<< " (" << ++finished << " done)" << std::endl;
+		workers.erase(workers.begin() + done);
+	}
+}
+
+static void writeSummary(const SweepSpec& spec, const std::vector<SweepResult>& results)
+{
+	std::ofstream csv(spec.output);
+	if (!csv) std::cerr << "sweep: cannot write " << spec.output << std::endl;
+
+	csv << "run";
+	std::cout << std::left << std::setw(5) << "run";
+	for (const SweepAxis& axis : spec.axes)
+	{
+		const std::string name = axis.section + "." + axis.key;
+		csv << "," << name;
+		std::cout << std::setw(std::max<int>(14, static_cast<int>(name.size()) + 2)) << name;
+	}
+	csv << ",status,frames,seconds,ms_per_frame,mean_density_error,max_density_error,max_speed,active_fraction\n";
+	std::cout << std::setw(10) << "status" << std::setw(10) << "ms/frame" << std::setw(14) << "mean error"
+		<< std::setw(14) << "max error" << std::setw(12) << "max speed" << "active" << std::endl;
+
+	for (int run = 0; run < static_cast<int>(results.size()); ++run)
+	{
+		const SweepResult& r = results[run];
+		const std::vector<int> values = runValues(spec, run);
+		const double perFrame = r.frames ? r.seconds * 1000.0 / r.frames : 0.0;
+		const char* status = statusNames[static_cast<int>(r.status)];
+
+		csv << run;
+		std::cout << std::setw(5) << run;
+		for (size_t a = 0; a < spec.axes.size(); ++a)
+		{
+			const std::string name = spec.axes[a].section + "." + spec.axes[a].key;
+			csv << "," << spec.axes[a].values[values[a]];
+			std::cout << std::setw(std::max<int>(14, static_cast<int>(name.size()) + 2)) << spec.axes[a].values[values[a]];
+		}
+		csv << "," << status << "," << r.frames << "," << r.seconds << "," << perFrame << "," << r.meanDensityError
+			<< "," << r.maxDensityError << "," << r.maxSpeed << "," << r.activeFraction << "\n";
+		std::cout << std::setw(10) << status << std::setw(10) << perFrame << std::setw(14) << r.meanDensityError
+			<< std::setw(14) << r.maxDensityError << std::setw(12) << r.maxSpeed << r.activeFraction << std::endl;
+	}
+}
+
+bool runSweep(const char* path, const int& worker)
+{
+	SweepSpec spec;
+	if (!parseSweep(path, spec)) return false;
+
+	const int count = runCount(spec);
+#ifdef _WIN32
+	spec.jobs = Min(spec.jobs, static_cast<int>(MAXIMUM_WAIT_OBJECTS));
+#endif
+	spec.jobs = Min(spec.jobs, count);
+
+	const int hardware = Max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+	if (spec.threads == 0) spec.threads = Min(Max(hardware / spec.jobs, 1), threads);
+
+	std::vector<SceneConfig> configs(count);
+	std::vector<bool> valid(count);
+	std::vector<SweepResult> results(count);
+
+	for (int run = 0; run < count; ++run)
+	{
+		valid[run] = runConfig(spec, run, configs[run]);
+		if (!valid[run]) results[run].status = SweepStatus::Invalid;
+	}
+
+	// one initial state from the base scene's [init] section shared by every run
+	const std::string initialState = spec.output + ".initial.fcp";
+
+	if (worker >= 0)
+	{
+		if (worker >= count || !valid[worker]) return false;
+
+		const SweepResult result = runSimulation(configs[worker], spec, initialState.c_str());
+		std::ofstream file(workerResultPath(spec, worker), std::ios::binary);
+		return static_cast<bool>(file.write(reinterpret_cast<const char*>(&result), sizeof(SweepResult)));
+	}
+
+	if (!writeInitialState(spec.base, initialState.c_str())) return false;
+
+	std::cout << "sweep: " << count << " runs of " << spec.frames << " frames, " << spec.jobs << " at once with "
+		<< spec.threads << " threads each" << std::endl;
+	const Clock::time_point start = Clock::now();
+
+	runWorkers(spec, configs, valid, initialState.c_str(), results);
+
+	const double wall = std::chrono::duration<double>(Clock::now() - start).count();
+	std::remove(initialState.c_str());
+
+	double busy = 0.0;
+	for (const SweepResult& r : results) busy += r.seconds;
+
+	writeSummary(spec, results);
+	std::cout << "sweep: " << wall << " s wall for " << busy << " s of simulation, "
+		<< (wall > 0.0 ? busy / wall : 0.0) << " runs in flight on average" << std::endl;
+	return true;
+}
@@ -0,0 +1,27 @@
+#ifndef SWEEP
+#define SWEEP
+
+// Parameter sweeps without the viewer. A sweep file lists values per scene
+// key and every combination is simulated from the same initial state:
+//
+//     [sweep]
+//     base = scenes/default.ini   ; scene the values are applied to
+//     frames = 600
+//     jobs = 4                    ; simulations running at once
+//     threads = 10                ; OpenMP threads of each simulation
+//     output = sweep.csv
+//
+//     [vary]
+//     pbf.viscosity = 0.02, 0.04, 0.08
+//     pbf.relaxation = 1e-6, 3e-6
+//
+// Every run restores the same checkpoint of the initial state. The solver
+// state lives in globals, so every run is a worker process of its own and
+// jobs of them run at once: forked on POSIX, started again with
+// --sweep-worker <run> on Windows. The summary table is printed and written
+// as CSV.
+
+// worker >= 0 runs only that configuration, as a worker process
+bool runSweep(const char* path, const int& worker = -1);
+
+#endif
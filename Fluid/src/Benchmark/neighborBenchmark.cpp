@@ -0,0 +1,214 @@
+#include "../NearestNeighborSearch/neighborLists.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Times every neighbor search backend on generated particle sets and checks
+// the neighbor sets they produce against a brute force search. The backends
+// use static arrays sized PARTICLES_NUMBER, so the sizes are fractions of it.
+
+enum class Distribution { Uniform, Clustered, Layered };
+
+static constexpr int repetitions = 20;
+static constexpr int sizes[] = { PARTICLES_NUMBER / 4, PARTICLES_NUMBER / 2, PARTICLES_NUMBER };
+
+alignas(64) static vec2 positions[PARTICLES_NUMBER];
+
+static std::vector<int> reference[PARTICLES_NUMBER];
+
+using Clock = std::chrono::steady_clock;
+
+static const char* name(const Distribution& distribution)
+{
+	switch (distribution)
+	{
+	case Distribution::Uniform:   return "uniform";
+	case Distribution::Clustered: return "clustered";
+	default:                      return "layered";
+	}
+}
+
+static void generate(const Distribution& distribution, const int& count)
+{
+	std::mt19937 rng(1234u + count);
+
+	const vec2 low(BOXMARGINX + radius, BOXMARGINY + radius);
+	const vec2 high(BOXMARGINX + BOXWIDTH - radius, BOXMARGINY + BOXHEIGHT - radius);
+
+	std::uniform_real_distribution<float> unitX(low.x, high.x);
+	std::uniform_real_distribution<float> unitY(low.y, high.y);
+
+	if (distribution == Distribution::Uniform)
+	{
+		for (int i = 0; i < count; ++i) positions[i] = vec2(unitX(rng), unitY(rng));
+	}
+	else if (distribution == Distribution::Clustered)
+	{
+		// a few dense blobs, like droplets after a splash
+		static constexpr int clusters = 8;
+		vec2 centers[clusters];
+		for (int c = 0; c < clusters; ++c) centers[c] = vec2(unitX(rng), unitY(rng));
+
+		std::normal_distribution<float> spread(0.0f, 1.5f * influenceRadius);
+		for (int i = 0; i < count; ++i)
+		{
+			const vec2 p = centers[i % clusters] + vec2(spread(rng), spread(rng));
+			positions[i] = glm::clamp(p, low, high);
+		}
+	}
+	else
+	{
+		// a settled pool: rows at the rest spacing filled from the bottom, slightly jittered
+		const float spacing = 2.0f * radius;
+		const int perRow = static_cast<int>((high.x - low.x) / spacing) + 1;
+
+		std::uniform_real_distribution<float> jitter(-0.1f * radius, 0.1f * radius);
+		for (int i = 0; i < count; ++i)
+		{
+			const int row = i / perRow;
+			const float offset = (row % 2) ? 0.5f * spacing : 0.0f;
+			const vec2 p(low.x + offset + (i % perRow) * spacing, high.y - row * spacing * 0.87f);
+			positions[i] = glm::clamp(p + vec2(jitter(rng), jitter(rng)), low, high);
+		}
+	}
+
+	for (int i = 0; i < count; ++i) smoothingLengths[i] = influenceRadius;
+}
+
+static void bruteForce(const int& count)
+{
+	for (int i = 0; i < count; ++i)
+	{
+		reference[i].clear();
+		for (int j = 0; j < count; ++j)
+		{
+			if (j != i && length2(positions[i] - positions[j]) < influenceRadius * influenceRadius)
+			{
+				reference[i].push_back(j);
+			}
+		}
+	}
+}
+
+// build(count) rebuilds the structure, query(i, func) visits the candidates of particle i
+template <typename Build, typename Query>
+static void run(const char* backend, const size_t& memory, const int& count, Build&& build, Query&& query)
+{
+	double buildTime = 0.0;
+	double queryTime = 0.0;
+	long long pairs = 0;
+
+	for (int r = 0; r < repetitions; ++r)
+	{
+		auto t0 = Clock::now();
+		build(count);
+		auto t1 = Clock::now();
+
+		for (int i = 0; i < count; ++i)
+		{
+			query(i, [&](const int& j)
+			{
+				pairs += length2(positions[i] - positions[j]) < influenceRadius * influenceRadius;
+			});
+		}
+		auto t2 = Clock::now();
+
+		buildTime += std::chrono::duration<double, std::nano>(t1 - t0).count();
+		queryTime += std::chrono::duration<double, std::nano>(t2 - t1).count();
+	}
+
+	int mismatches = 0;
+	std::vector<int> found;
+	for (int i = 0; i < count; ++i)
+	{
+		found.clear();
+		query(i, [&](const int& j)
+		{
+			if (length2(positions[i] - positions[j]) < influenceRadius * influenceRadius) found.push_back(j);
+		});
+		std::sort(found.begin(), found.end());
+		mismatches += found != reference[i];
+	}
+
+	const double perParticle = 1.0 / (static_cast<double>(repetitions) * count);
+
+	std::cout << "  " << std::left << std::setw(14) << backend << std::right
+		<< std::fixed << std::setprecision(1)
+		<< std::setw(10) << buildTime * perParticle
+		<< std::setw(10) << queryTime * perParticle
+		<< std::setw(10) << (buildTime + queryTime) * perParticle
+		<< std::setw(10) << memory / 1024.0
+		<< std::setw(10) << static_cast<double>(pairs) / (static_cast<double>(repetitions) * count)
+		<< "   " << (mismatches ? "FAILED " + std::to_string(mismatches) : std::string("ok"))
+		<< std::endl;
+}
+
+int main()
+{
+	std::cout << "neighbor search benchmark, influence radius " << influenceRadius
+		<< ", " << repetitions << " repetitions\n"
+		<< "  times in ns per particle, memory in KB\n";
+
+	for (const Distribution distribution : { Distribution::Uniform, Distribution::Clustered, Distribution::Layered })
+	{
+		for (const int count : sizes)
+		{
+			generate(distribution, count);
+			bruteForce(count);
+
+			std::cout << "\n" << name(distribution) << ", " << count << " particles\n"
+				<< "  backend            build     query     total    memory neighbors\n";
+
+			run("segments", sizeof(List), count,
+				[](const int& n) { buildSegments(positions, n); },
+				[](const int& i, auto&& func) {
+					const unsigned segInd = GetSegmentIndex(positions[i]);
+					for (int locShift = 0; locShift < 9; locShift++)
+					{
+						for (Node* seg = segments.segments[GetLocationFromShift(segInd, locShift)]; seg; seg = seg->next)
+						{
+							if (seg->value != i) func(seg->value);
+						}
+					}
+				});
+			for (int k = 1; k <= maxCellDivisions; ++k)
+			{
+				const std::string label = "compact h/" + std::to_string(k);
+				setCompactGridDivisions(k);
+				run(label.c_str(), sizeof(CompactGrid), count,
+					[](const int& n) { rebuildCompactGrid(positions, n); },
+					[](const int& i, auto&& func) { forEachCompactNeighbor(i, positions[i], func); });
+			}
+			tuneCompactGrid(positions, count);
+			std::cout << "  compact grid: tuned to h/" << compactGrid.divisions << ", "
+				<< compactGrid.candidateRatio << " candidates per neighbor" << std::endl;
+
+			run("hash grid", sizeof(HashGrid), count,
+				[](const int& n) { rebuildHashGrid(positions, n); },
+				[](const int& i, auto&& func) { forEachHashNeighbor(i, positions[i], func); });
+			run("quadtree", sizeof(Quadtree), count,
+				[](const int& n) { rebuildQuadtree(positions, n); },
+				[](const int& i, auto&& func) { forEachQuadtreeNeighbor(i, positions[i], func); });
+
+			// the lists are gathered through the backend selected in settings
+			run("lists", sizeof(NeighborLists), count,
+				[](const int& n) {
+					if constexpr (neighborSearch == NeighborSearch::Segments) buildSegments(positions, n);
+					else refreshNeighborSearch(positions, n);
+					buildNeighborLists(positions, n);
+				},
+				[](const int& i, auto&& func) { forEachListedNeighbor(i, func); });
+
+			if (neighborLists.overflows)
+			{
+				std::cout << "  lists dropped " << neighborLists.overflows << " neighbors over " << maxNeighbors << std::endl;
+			}
+		}
+	}
+	return 0;
+}
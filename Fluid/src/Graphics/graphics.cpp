@@ -118,7 +118,7 @@ void PassUniformConstants(GLuint& prog)
     GLint particleInfluenceRadiusLocation = glGetUniformLocation(prog, "particleInfluenceRadius");
     glUniform1f(particleInfluenceRadiusLocation, influenceRadius);
 }
-void PassUniforms(GLuint& prog, GLuint& UBO, GLint& blockSize)
+void PassUniforms(GLuint& prog, GLuint& SSBO, GLint& blockSize, const vec2* positions)
 {
     GLint iResolutionLocation = glGetUniformLocation(prog, "iResolution");
     glUniform2f(iResolutionLocation, static_cast<float>(WWIDTH), static_cast<float>(WHEIGHT));
@@ -135,18 +135,10 @@ void PassUniforms(GLuint& prog, GLuint& UBO, GLint& blockSize)
     GLint targetDensityLocation = glGetUniformLocation(prog, "targetDensity");
     glUniform1f(targetDensityLocation, targetDensity);
 
-    std::vector<GLfloat> data(blockSize / 4);
-    for (size_t i = 0; i < PARTICLES_NUMBER; ++i)
-    {
-        data[i * 4] = particles.centers[i].x;
-        data[i * 4 + 1] = particles.centers[i].y;
-        data[i * 4 + 2] = 0.0;
-        data[i * 4 + 3] = 0.0;
-    }
-
-    glBindBuffer(GL_UNIFORM_BUFFER, UBO);
-    glBufferSubData(GL_UNIFORM_BUFFER, 0, blockSize, data.data());
-    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    // std430 packs vec2 like the positions array, no staging copy
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, SSBO);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, blockSize, positions);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 
     GLint particleRadiusLocation = glGetUniformLocation(prog, "particleRadius");
     glUniform1f(particleRadiusLocation, radius);
@@ -163,16 +155,13 @@ void setupViewSettingsAndData(GLuint& buffer, GLuint& prog, GLint& blockSize)
     glClearColor(0.2f, 0.2f, 0.2f, 1.f);
 
     // particles
-    GLint particleBlockLocation = glGetUniformBlockIndex(prog, "ParticlesBlock");
-
-    glUniformBlockBinding(prog, particleBlockLocation, 0);
-    glGetActiveUniformBlockiv(prog, particleBlockLocation, GL_UNIFORM_BLOCK_DATA_SIZE, &blockSize);
+    blockSize = PARTICLES_NUMBER * sizeof(vec2);
 
     glCreateBuffers(1, &buffer);
-    glBindBufferBase(GL_UNIFORM_BUFFER, 0, buffer);
-    glBindBuffer(GL_UNIFORM_BUFFER, buffer);
-    glBufferData(GL_UNIFORM_BUFFER, blockSize, 0, GL_DYNAMIC_DRAW);
-    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, buffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, blockSize, 0, GL_STREAM_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 }
 
 
@@ -21,7 +21,7 @@ std::string LoadShader(const std::string& path);
 GLuint CompileShader(const GLuint& type, const std::string& shaderCode, bool& success);
 bool InitGL(GLuint& gProgramID);
 void ShadeScreen(GLuint& gVBO, GLuint& gIBO, GLint& gVertexPos2DLocation);
-void PassUniforms(GLuint& prog, GLuint& UBO, GLint& blockSize);
+void PassUniforms(GLuint& prog, GLuint& SSBO, GLint& blockSize, const vec2* positions = particles.centers);
 void setupViewSettingsAndData(GLuint& buffer, GLuint& prog, GLint& blockSize);
 void PassUniformConstants(GLuint& prog);
 
@@ -0,0 +1,231 @@
+#include "iisph.hpp"
+
+static constexpr float diagonal_epsilon  = 1e-9f;
+
+alignas(64) float densities[PARTICLES_NUMBER];
+alignas(64) float pressures[PARTICLES_NUMBER];
+
+alignas(64) static float pressuresNext[PARTICLES_NUMBER];
+alignas(64) static float densitiesAdv[PARTICLES_NUMBER];
+alignas(64) static float aii[PARTICLES_NUMBER];
+
+alignas(64) static vec2 dii[PARTICLES_NUMBER];
+alignas(64) static vec2 sumDij[PARTICLES_NUMBER];
+alignas(64) static vec2 velocityAdv[PARTICLES_NUMBER];
+
+static float densityError = 0.0f;
+
+// poly6 for densities, spiky for pressure gradients
+using Density  = KernelBackend<Kernels::Poly6>;
+using Gradient = KernelBackend<Kernels::Spiky>;
+
+static const scalar restDensity = iisphRestDensity();
+
+void iisphUpdate()
+{
+	float vmax = 0.0f;
+
+	#pragma omp parallel for reduction(max:vmax) num_threads(scene.threads)
+	for (int i = 0; i < PARTICLES_NUMBER; ++i)
+	{
+		vmax = Max(vmax, glm::length(particles.dir[i]));
+	}
+
+	// the fixed step is only shortened when the fastest particle would cross more than a diameter
+	const float step = (vmax > 0.0f) ? Min(scene.iisphDt, scene.cfl * 2.0f * radius / vmax) : scene.iisphDt;
+
+	#pragma omp parallel num_threads(scene.threads)
+	{
+		#pragma omp for schedule(dynamic, PARTICLES_NUMBER / threads)
+		for (int i = 0; i < PARTICLES_NUMBER; ++i)
+		{
+			iisphComputeDensity(i);
+		}
+
+		#pragma omp for schedule(dynamic, PARTICLES_NUMBER / threads)
+		for (int i = 0; i < PARTICLES_NUMBER; ++i)
+		{
+			iisphPredictAdvection(i, step);
+		}
+
+		#pragma omp for schedule(dynamic, PARTICLES_NUMBER / threads)
+		for (int i = 0; i < PARTICLES_NUMBER; ++i)
+		{
+			iisphPrepareSolver(i, step);
+		}
+
+		// relaxed Jacobi on the pressure Poisson equation
+		for (int l = 0; l < scene.maxIterations; ++l)
+		{
+			#pragma omp for schedule(dynamic, PARTICLES_NUMBER / (2 * threads))
+			for (int i = 0; i < PARTICLES_NUMBER; ++i)
+			{
+				iisphSumDisplacement(i, step);
+			}
+
+			#pragma omp single
+			densityError = 0.0f;
+
+			#pragma omp for schedule(dynamic, PARTICLES_NUMBER / (2 * threads)) reduction(+:densityError)
+			for (int i = 0; i < PARTICLES_NUMBER; ++i)
+			{
+				densityError += iisphRelaxPressure(i, step);
+			}
+
+			#pragma omp for schedule(static)
+			for (int i = 0; i < PARTICLES_NUMBER; ++i)
+			{
+				pressures[i] = pressuresNext[i];
+			}
+
+			const float error = densityError / (PARTICLES_NUMBER * restDensity);
+			if (l + 1 >= scene.minIterations && error <= scene.maxDensityError) break;
+		}
+
+		#pragma omp for schedule(dynamic, PARTICLES_NUMBER / threads)
+		for (int i = 0; i < PARTICLES_NUMBER; ++i)
+		{
+			iisphPressureAcceleration(i, step);
+		}
+
+		#pragma omp for schedule(dynamic, PARTICLES_NUMBER / threads)
+		for (int i = 0; i < PARTICLES_NUMBER; ++i)
+		{
+			vec2 shift = particles.dir[i] * step;
+			prediction[i] = particles.centers[i];
+
+			boundaryCondition(i, shift);
+			prediction[i] += shift;
+			particles.dir[i] = shift / step;
+
+			newUpdateSegment(i);
+			particles.centers[i] = prediction[i];
+		}
+		refreshNeighborSearch(prediction);
+	}
+}
+
+void iisphComputeDensity(const int& Index)
+{
+	float density = mass * Density::selfValue;
+
+	forEachNeighbor(Index, particles.centers[Index], [&](const int& j)
+	{
+		density += mass * Density::value(glm::length(particles.centers[Index] - particles.centers[j]));
+	});
+
+	densities[Index] = density;
+}
+void iisphPredictAdvection(const int& Index, const float& step)
+{
+	const float rho2 = densities[Index] * densities[Index];
+
+	vec2 xsph(0.0f, 0.0f);
+	vec2 d(0.0f, 0.0f);
+
+	forEachNeighbor(Index, particles.centers[Index], [&](const int& j)
+	{
+		const vec2 dir = particles.centers[Index] - particles.centers[j];
+		const scalar dst = glm::length(dir);
+
+		xsph += (mass / densities[j]) * (particles.dir[j] - particles.dir[Index]) * Density::value(dst);
+		d -= (mass / rho2) * Gradient::gradientCoeff(dst) * dir;
+	});
+
+	velocityAdv[Index] = particles.dir[Index] + ExternalForces(particles.centers[Index], particles.dir[Index]) * step;
+	velocityAdv[Index] += scene.xsphViscosity * xsph;
+
+	dii[Index] = d * step * step;
+}
+void iisphPrepareSolver(const int& Index, const float& step)
+{
+	const float rho2 = densities[Index] * densities[Index];
+
+	float divergence = 0.0f;
+	float a = 0.0f;
+
+	forEachNeighbor(Index, particles.centers[Index], [&](const int& j)
+	{
+		const vec2 dir = particles.centers[Index] - particles.centers[j];
+		const vec2 grad = Gradient::gradientCoeff(glm::length(dir)) * dir;
+		const vec2 dji = grad * (step * step * mass / rho2);
+
+		divergence += mass * glm::dot(velocityAdv[Index] - velocityAdv[j], grad);
+		a += mass * glm::dot(dii[Index] - dji, grad);
+	});
+
+	densitiesAdv[Index] = densities[Index] + step * divergence;
+	aii[Index] = a;
+
+	// warm start from the previous step
+	pressures[Index] *= 0.5f;
+}
+void iisphSumDisplacement(const int& Index, const float& step)
+{
+	vec2 sum(0.0f, 0.0f);
+
+	forEachNeighbor(Index, particles.centers[Index], [&](const int& j)
+	{
+		const vec2 dir = particles.centers[Index] - particles.centers[j];
+		const vec2 grad = Gradient::gradientCoeff(glm::length(dir)) * dir;
+		sum -= (mass * pressures[j] / (densities[j] * densities[j])) * grad;
+	});
+
+	sumDij[Index] = sum * step * step;
+}
+float iisphRelaxPressure(const int& Index, const float& step)
+{
+	const float rho2 = densities[Index] * densities[Index];
+	float sum = 0.0f;
+
+	forEachNeighbor(Index, particles.centers[Index], [&](const int& j)
+	{
+		const vec2 dir = particles.centers[Index] - particles.centers[j];
+		const vec2 grad = Gradient::gradientCoeff(glm::length(dir)) * dir;
+		const vec2 dji = grad * (step * step * mass / rho2);
+
+		const vec2 v = sumDij[Index] - dii[j] * pressures[j] - (sumDij[j] - dji * pressures[Index]);
+		sum += mass * glm::dot(v, grad);
+	});
+
+	float p = 0.0f;
+	if (glm::abs(aii[Index]) > diagonal_epsilon)
+	{
+		p = (1.0f - scene.omega) * pressures[Index] + scene.omega / aii[Index] * (restDensity - densitiesAdv[Index] - sum);
+	}
+	pressuresNext[Index] = Max(p, 0.0f);
+
+	// only compression counts, free surface particles are allowed to be below rest density
+	return Max(densitiesAdv[Index] + aii[Index] * pressures[Index] + sum - restDensity, 0.0f);
+}
+void iisphPressureAcceleration(const int& Index, const float& step)
+{
+	const float pi = pressures[Index] / (densities[Index] * densities[Index]);
+	vec2 accel(0.0f, 0.0f);
+
+	forEachNeighbor(Index, particles.centers[Index], [&](const int& j)
+	{
+		const vec2 dir = particles.centers[Index] - particles.centers[j];
+		const vec2 grad = Gradient::gradientCoeff(glm::length(dir)) * dir;
+		accel -= mass * (pi + pressures[j] / (densities[j] * densities[j])) * grad;
+	});
+
+	particles.dir[Index] = velocityAdv[Index] + accel * step;
+}
+
+float iisphRestDensity()
+{
+	// density of a particle inside a perfectly sampled lattice with the rendering spacing
+	const float spacing = 2.0f * radius;
+	const int n = staticCeil(influenceRadius / spacing);
+
+	float density = mass * Density::selfValue;
+	for (int x = -n; x <= n; ++x)
+	{
+		for (int y = -n; y <= n; ++y)
+		{
+			density += mass * Density::value(glm::length(vec2(x, y) * spacing));
+		}
+	}
+	return density;
+}
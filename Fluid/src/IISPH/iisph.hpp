@@ -0,0 +1,23 @@
+#ifndef IISPH_HPP
+#define IISPH_HPP
+
+#include "../PBF/particles.hpp"
+
+// Implicit incompressible SPH (Ihmsen et al. 2013).
+// Shares particles, prediction and the configured neighbor search with the PBF
+// solver; velocities are stored in particles.dir as real velocities (px / time unit).
+
+extern alignas(64) float densities[PARTICLES_NUMBER];
+extern alignas(64) float pressures[PARTICLES_NUMBER];
+
+void iisphUpdate();
+void iisphComputeDensity(const int& Index);
+void iisphPredictAdvection(const int& Index, const float& step);
+void iisphPrepareSolver(const int& Index, const float& step);
+void iisphSumDisplacement(const int& Index, const float& step);
+float iisphRelaxPressure(const int& Index, const float& step);
+void iisphPressureAcceleration(const int& Index, const float& step);
+
+float iisphRestDensity();
+
+#endif
@@ -0,0 +1,111 @@
+#include "asyncWriter.hpp"
+
+#include <chrono>
+#include <iostream>
+
+using Clock = std::chrono::steady_clock;
+
+AsyncWriter::AsyncWriter(const int& depth, const size_t& bufferBytes, const Backpressure& policy, Consume consume, void* context)
+	: pool(depth), queue(depth), policy(policy), consume(consume), context(context)
+{
+	// the buffers are sized once, filling them never allocates
+	idle.reserve(depth);
+	for (WriteBuffer& buffer : pool)
+	{
+		buffer.data.resize(bufferBytes);
+		idle.push_back(&buffer);
+	}
+
+	worker = std::thread(&AsyncWriter::run, this);
+}
+AsyncWriter::~AsyncWriter()
+{
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		stopping = true;
+	}
+	bufferQueued.notify_one();
+	worker.join();
+}
+
+WriteBuffer* AsyncWriter::acquire()
+{
+	std::unique_lock<std::mutex> guard(lock);
+
+	if (idle.empty())
+	{
+		if (policy == Backpressure::Drop)
+		{
+			counters.dropped++;
+			return nullptr;
+		}
+
+		const Clock::time_point start = Clock::now();
+		bufferFreed.wait(guard, [this] { return !idle.empty(); });
+		counters.stallTime += std::chrono::duration<double>(Clock::now() - start).count();
+	}
+
+	WriteBuffer* buffer = idle.back();
+	idle.pop_back();
+	buffer->size = 0;
+	return buffer;
+}
+void AsyncWriter::submit(WriteBuffer* buffer)
+{
+	{
+		std::lock_guard<std::mutex> guard(lock);
+
+		queue[(head + queued) % queue.size()] = buffer;
+		queued++;
+		counters.submitted++;
+		counters.bytes += buffer->size;
+	}
+	bufferQueued.notify_one();
+}
+void AsyncWriter::flush()
+{
+	std::unique_lock<std::mutex> guard(lock);
+	bufferFreed.wait(guard, [this] { return queued == 0 && !writing; });
+}
+
+AsyncWriterStats AsyncWriter::stats()
+{
+	std::lock_guard<std::mutex> guard(lock);
+	return counters;
+}
+void AsyncWriter::report(const char* name)
+{
+	const AsyncWriterStats s = stats();
+
+	std::cout << name << ": " << s.submitted << " buffers, " << s.bytes / (1024.0 * 1024.0) << " MB, "
+		<< s.dropped << " dropped, producer stalled " << s.stallTime * 1000.0 << " ms, "
+		<< "I/O thread busy " << s.writeTime * 1000.0 << " ms" << std::endl;
+}
+
+void AsyncWriter::run()
+{
+	std::unique_lock<std::mutex> guard(lock);
+
+	while (true)
+	{
+		bufferQueued.wait(guard, [this] { return queued > 0 || stopping; });
+		if (queued == 0) break;
+
+		WriteBuffer* buffer = queue[head];
+		head = (head + 1) % static_cast<int>(queue.size());
+		queued--;
+		writing = true;
+
+		// the producer keeps filling other buffers while this one is written
+		guard.unlock();
+		const Clock::time_point start = Clock::now();
+		consume(*buffer, context);
+		const double time = std::chrono::duration<double>(Clock::now() - start).count();
+		guard.lock();
+
+		counters.writeTime += time;
+		writing = false;
+		idle.push_back(buffer);
+		bufferFreed.notify_all();
+	}
+}
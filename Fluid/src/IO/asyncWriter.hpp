@@ -0,0 +1,78 @@
+#ifndef ASYNC_WRITER
+#define ASYNC_WRITER
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Hands byte buffers to a dedicated I/O thread. Buffers come from a fixed
+// pool: the producer acquires one, fills it and submits it, the I/O thread
+// passes it to the consume function and returns it to the pool. The pool size
+// bounds the queue; when every buffer is in flight the backpressure policy
+// either stalls the producer or drops the buffer it asked for.
+
+enum class Backpressure { Block, Drop };
+
+struct WriteBuffer
+{
+	std::vector<unsigned char> data;
+	size_t   size = 0;
+	uint64_t tag  = 0;
+};
+
+struct AsyncWriterStats
+{
+	uint64_t submitted = 0;
+	uint64_t dropped   = 0;
+	uint64_t bytes     = 0;
+	double   stallTime = 0.0;
+	double   writeTime = 0.0;
+};
+
+class AsyncWriter
+{
+public:
+	// consume runs on the I/O thread, one buffer at a time in submission order
+	using Consume = void (*)(WriteBuffer& buffer, void* context);
+
+	AsyncWriter(const int& depth, const size_t& bufferBytes, const Backpressure& policy, Consume consume, void* context);
+	// drains the queue before the thread exits
+	~AsyncWriter();
+
+	AsyncWriter(const AsyncWriter&) = delete;
+	AsyncWriter& operator=(const AsyncWriter&) = delete;
+
+	// nullptr when the pool is exhausted and the policy drops
+	WriteBuffer* acquire();
+	void submit(WriteBuffer* buffer);
+	// waits until every submitted buffer has been consumed
+	void flush();
+
+	AsyncWriterStats stats();
+	void report(const char* name);
+
+private:
+	void run();
+
+	std::vector<WriteBuffer>  pool;
+	std::vector<WriteBuffer*> idle;
+	std::vector<WriteBuffer*> queue;
+	int head = 0;
+	int queued = 0;
+	bool writing = false;
+	bool stopping = false;
+
+	const Backpressure policy;
+	const Consume consume;
+	void* const context;
+	AsyncWriterStats counters;
+
+	std::mutex lock;
+	std::condition_variable bufferFreed;
+	std::condition_variable bufferQueued;
+	std::thread worker;
+};
+
+#endif
@@ -0,0 +1,213 @@
+#include "checkpoint.hpp"
+#include "mappedFile.hpp"
+#include "../PBF/particles.hpp"
+#include "../PBF/activity.hpp"
+#include "../PBF/multirate.hpp"
+#include "../IISPH/iisph.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <filesystem>
+#include <string>
+
+static constexpr char     checkpointMagic[8] = { 'F', 'L', 'U', 'I', 'D', 'C', 'P', '\0' };
+static constexpr uint32_t checkpointEndianTag = 0x01020304u;
+
+struct StateArray
+{
+	CheckpointArray id;
+	void* data;
+	uint32_t elementSize;
+};
+
+static const StateArray stateArrays[] =
+{
+	{ CheckpointArray::Centers,          particles.centers, sizeof(Point) },
+	{ CheckpointArray::Velocities,       particles.dir,     sizeof(vec2)  },
+	{ CheckpointArray::Prediction,       prediction,        sizeof(vec2)  },
+	{ CheckpointArray::External,         external,          sizeof(vec2)  },
+	{ CheckpointArray::Lambdas,          lambdas,           sizeof(float) },
+	{ CheckpointArray::DensityErrors,    densityErrors,     sizeof(float) },
+	{ CheckpointArray::StepSizes,        stepSizes,         sizeof(float) },
+	{ CheckpointArray::SmoothingLengths, smoothingLengths,  sizeof(float) },
+	{ CheckpointArray::Levels,           levels,            sizeof(int)   },
+	{ CheckpointArray::Densities,        densities,         sizeof(float) },
+	{ CheckpointArray::Pressures,        pressures,         sizeof(float) },
+};
+static constexpr int stateArrayCount = sizeof(stateArrays) / sizeof(stateArrays[0]);
+static_assert(stateArrayCount <= checkpointMaxArrays, "checkpoint header has no room for every array");
+
+static uint64_t alignOffset(const uint64_t& offset)
+{
+	return (offset + checkpointAlignment - 1) / checkpointAlignment * checkpointAlignment;
+}
+
+static CheckpointHeader sceneHeader()
+{
+	CheckpointHeader header = {};
+
+	std::memcpy(header.magic, checkpointMagic, sizeof(checkpointMagic));
+	header.version    = checkpointVersion;
+	header.headerSize = sizeof(CheckpointHeader);
+	header.endianTag  = checkpointEndianTag;
+	header.particles  = PARTICLES_NUMBER;
+
+	header.solver    = static_cast<uint32_t>(solver);
+	header.boxWidth  = BOXWIDTH;
+	header.boxHeight = BOXHEIGHT;
+	header.scale     = scale;
+	header.area      = area;
+	header.radius    = radius;
+
+	return header;
+}
+
+bool saveCheckpoint(const char* path, const uint64_t& frame)
+{
+	CheckpointHeader header = sceneHeader();
+	header.frame = frame;
+	header.arrayCount = stateArrayCount;
+
+	uint64_t offset = alignOffset(sizeof(CheckpointHeader));
+	for (int a = 0; a < stateArrayCount; ++a)
+	{
+		CheckpointEntry& entry = header.arrays[a];
+
+		entry.id          = static_cast<uint32_t>(stateArrays[a].id);
+		entry.elementSize = stateArrays[a].elementSize;
+		entry.offset      = offset;
+		entry.bytes       = static_cast<uint64_t>(stateArrays[a].elementSize) * PARTICLES_NUMBER;
+
+		offset = alignOffset(offset + entry.bytes);
+	}
+
+	// written next to the target and renamed, a crash never leaves a torn checkpoint behind
+	const std::string temporary = std::string(path) + ".tmp";
+	{
+		std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+		if (!out)
+		{
+			std::cerr << "checkpoint: cannot open " << temporary << std::endl;
+			return false;
+		}
+
+		static const char padding[checkpointAlignment] = { 0 };
+		uint64_t written = sizeof(CheckpointHeader);
+		out.write(reinterpret_cast<const char*>(&header), sizeof(CheckpointHeader));
+
+		for (int a = 0; a < stateArrayCount; ++a)
+		{
+			const CheckpointEntry& entry = header.arrays[a];
+
+			out.write(padding, static_cast<std::streamsize>(entry.offset - written));
+			out.write(static_cast<const char*>(stateArrays[a].data), static_cast<std::streamsize>(entry.bytes));
+			written = entry.offset + entry.bytes;
+		}
+		out.write(padding, static_cast<std::streamsize>(offset - written));
+
+		if (!out)
+		{
+			std::cerr << "checkpoint: writing " << temporary << " failed" << std::endl;
+			return false;
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::rename(temporary, path, error);
+	if (error)
+	{
+		std::cerr << "checkpoint: cannot replace " << path << ": " << error.message() << std::endl;
+		return false;
+	}
+	return true;
+}
+
+// rejects files that do not describe the compiled scene, the arrays would not line up
+static bool validateHeader(const CheckpointHeader& header, const size_t& fileSize, const char* path)
+{
+	const CheckpointHeader expected = sceneHeader();
+
+	if (std::memcmp(header.magic, checkpointMagic, sizeof(checkpointMagic)) != 0)
+	{
+		std::cerr << "checkpoint: " << path << " is not a checkpoint" << std::endl;
+		return false;
+	}
+	if (header.endianTag != checkpointEndianTag)
+	{
+		std::cerr << "checkpoint: " << path << " was written with another byte order" << std::endl;
+		return false;
+	}
+	if (header.version > checkpointVersion || header.headerSize > fileSize || header.arrayCount > checkpointMaxArrays)
+	{
+		std::cerr << "checkpoint: " << path << " has unsupported version " << header.version << std::endl;
+		return false;
+	}
+	if (header.particles != expected.particles || header.boxWidth != expected.boxWidth || header.boxHeight != expected.boxHeight
+		|| header.scale != expected.scale || header.area != expected.area)
+	{
+		std::cerr << "checkpoint: " << path << " holds " << header.particles << " particles in a "
+			<< header.boxWidth << "x" << header.boxHeight << " box, the build expects "
+			<< expected.particles << " in " << expected.boxWidth << "x" << expected.boxHeight << std::endl;
+		return false;
+	}
+	if (header.solver != expected.solver)
+	{
+		std::cout << "checkpoint: " << path << " was written by the other solver, velocities may need a few frames to settle" << std::endl;
+	}
+	return true;
+}
+
+bool loadCheckpoint(const char* path, uint64_t* frame)
+{
+	const MappedFile file(path);
+	if (!file.data())
+	{
+		std::cerr << "checkpoint: cannot map " << path << std::endl;
+		return false;
+	}
+	if (file.size() < sizeof(CheckpointHeader))
+	{
+		std::cerr << "checkpoint: " << path << " is truncated" << std::endl;
+		return false;
+	}
+
+	CheckpointHeader header;
+	std::memcpy(&header, file.data(), sizeof(CheckpointHeader));
+	if (!validateHeader(header, file.size(), path)) return false;
+
+	// every entry is checked before anything is copied, a bad file leaves the state untouched
+	const StateArray* targets[checkpointMaxArrays] = { nullptr };
+	for (uint32_t e = 0; e < header.arrayCount; ++e)
+	{
+		const CheckpointEntry& entry = header.arrays[e];
+
+		for (int a = 0; a < stateArrayCount; ++a)
+		{
+			if (static_cast<uint32_t>(stateArrays[a].id) == entry.id) targets[e] = stateArrays + a;
+		}
+		if (!targets[e]) continue;
+
+		const uint64_t bytes = static_cast<uint64_t>(targets[e]->elementSize) * PARTICLES_NUMBER;
+		if (entry.elementSize != targets[e]->elementSize || entry.bytes != bytes
+			|| entry.offset > file.size() || entry.bytes > file.size() - entry.offset)
+		{
+			std::cerr << "checkpoint: array " << entry.id << " of " << path << " is malformed" << std::endl;
+			return false;
+		}
+	}
+
+	for (uint32_t e = 0; e < header.arrayCount; ++e)
+	{
+		if (!targets[e]) continue;
+		std::memcpy(targets[e]->data, file.data() + header.arrays[e].offset, header.arrays[e].bytes);
+	}
+
+	// the grids follow prediction, as they do between solver steps
+	buildSegments(prediction);
+	refreshNeighborSearch(prediction);
+	wakeAll();
+
+	if (frame) *frame = header.frame;
+	return true;
+}
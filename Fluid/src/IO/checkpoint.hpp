@@ -0,0 +1,61 @@
+#ifndef CHECKPOINT
+#define CHECKPOINT
+
+#include "../settings.hpp"
+
+#include <cstdint>
+
+// Binary snapshot of the full solver state. A fixed header describing the
+// scene is followed by a table of arrays; every array is stored raw at a
+// 64 byte aligned offset so loading is one mapping and a memcpy per array.
+// Arrays with an unknown id are skipped and missing ones keep their current
+// values, so newer builds read older checkpoints.
+
+static constexpr uint32_t checkpointVersion   = 1;
+static constexpr uint32_t checkpointAlignment = 64;
+static constexpr int      checkpointMaxArrays = 16;
+
+static constexpr const char* checkpointPath = "checkpoint.fcp";
+
+enum class CheckpointArray : uint32_t
+{
+	Centers = 1, Velocities, Prediction, External,
+	Lambdas, DensityErrors, StepSizes, SmoothingLengths,
+	Levels, Densities, Pressures
+};
+
+struct CheckpointEntry
+{
+	uint32_t id;
+	uint32_t elementSize;
+	uint64_t offset;
+	uint64_t bytes;
+};
+
+struct CheckpointHeader
+{
+	char     magic[8];
+	uint32_t version;
+	uint32_t headerSize;
+	uint32_t endianTag;
+	uint32_t particles;
+
+	// scene the state belongs to, a mismatch is reported on load
+	uint32_t solver;
+	uint32_t boxWidth;
+	uint32_t boxHeight;
+	float    scale;
+	float    area;
+	float    radius;
+
+	uint64_t frame;
+	uint32_t arrayCount;
+	uint32_t reserved;
+	CheckpointEntry arrays[checkpointMaxArrays];
+};
+
+bool saveCheckpoint(const char* path, const uint64_t& frame = 0);
+// on success the neighbor search is rebuilt and every particle is woken up
+bool loadCheckpoint(const char* path, uint64_t* frame = nullptr);
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef LIVE_CHANNEL
+#define LIVE_CHANNEL
+
+#include <atomic>
+#include <cstdint>
+
+// Layout of the shared memory block the solver publishes its frames to, read
+// by liveReader in other processes. Only fixed size types, so a consumer
+// needs this header and not the solver's.
+//
+//     LiveChannelHeader
+//     slot 0: LiveSlotHeader, positions[2 * particles], velocities[2 * particles]
+//     slot 1 ...
+//
+// The slots form a ring the solver fills in turn. Each slot is guarded by a
+// sequence lock: its sequence is odd while the solver writes the slot and
+// advances to the next even number when the frame is complete, so a reader
+// that sees the same even sequence before and after using a frame knows it
+// was not overwritten meanwhile. A reader of the latest frame has slots - 1
+// further frames of time before the solver comes back to its slot.
+
+static constexpr char     liveChannelMagic[8] = { 'F', 'L', 'U', 'I', 'D', 'L', 'V', '\0' };
+static constexpr uint32_t liveChannelVersion = 1;
+static constexpr uint32_t liveChannelSlots = 4;
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+	"the live channel needs address free atomics");
+
+struct alignas(64) LiveChannelHeader
+{
+	char     magic[8];
+	uint32_t version;
+	uint32_t headerSize;
+	uint32_t particles;
+	uint32_t slots;
+	uint64_t slotBytes;
+	uint64_t firstSlot;		// offset of slot 0
+	uint32_t boxWidth;
+	uint32_t boxHeight;
+	float    scale;
+
+	// frames published so far, the latest one is in slot (published - 1) % slots
+	std::atomic<uint64_t> published;
+	// set when the solver shuts down
+	std::atomic<uint32_t> closed;
+};
+
+struct alignas(64) LiveSlotHeader
+{
+	std::atomic<uint64_t> sequence;
+	uint64_t frame;
+};
+
+// positions and velocities are float pairs, the payload follows the slot header
+inline constexpr uint64_t liveSlotBytes(const uint64_t& particles)
+{
+	return (sizeof(LiveSlotHeader) + 4 * particles * sizeof(float) + 63) / 64 * 64;
+}
+inline constexpr uint64_t liveChannelBytes(const uint64_t& particles, const uint64_t& slots)
+{
+	return sizeof(LiveChannelHeader) + slots * liveSlotBytes(particles);
+}
+
+#endif
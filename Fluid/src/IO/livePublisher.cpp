@@ -0,0 +1,81 @@
+#include "livePublisher.hpp"
+#include "liveChannel.hpp"
+#include "sharedMemory.hpp"
+#include "../PBF/particles.hpp"
+
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <new>
+
+static std::unique_ptr<SharedMemory> liveMemory;
+
+static LiveSlotHeader& liveSlot(const uint64_t& index)
+{
+	const LiveChannelHeader& header = *reinterpret_cast<LiveChannelHeader*>(liveMemory->data());
+	return *reinterpret_cast<LiveSlotHeader*>(liveMemory->data() + header.firstSlot + index % header.slots * header.slotBytes);
+}
+
+bool openLiveChannel(const char* name)
+{
+	closeLiveChannel();
+
+	const uint64_t bytes = liveChannelBytes(PARTICLES_NUMBER, liveChannelSlots);
+	auto memory = std::make_unique<SharedMemory>(name, SharedAccess::Create, bytes);
+	if (!memory->data())
+	{
+		std::cerr << "live channel: cannot create shared memory " << name << std::endl;
+		return false;
+	}
+
+	// fresh shared memory is zeroed, every slot starts with an even sequence
+	LiveChannelHeader& header = *new (memory->data()) LiveChannelHeader{};
+	std::memcpy(header.magic, liveChannelMagic, sizeof(liveChannelMagic));
+	header.version    = liveChannelVersion;
+	header.headerSize = sizeof(LiveChannelHeader);
+	header.particles  = PARTICLES_NUMBER;
+	header.slots      = liveChannelSlots;
+	header.slotBytes  = liveSlotBytes(PARTICLES_NUMBER);
+	header.firstSlot  = sizeof(LiveChannelHeader);
+	header.boxWidth   = BOXWIDTH;
+	header.boxHeight  = BOXHEIGHT;
+	header.scale      = scale;
+
+	liveMemory = std::move(memory);
+	for (uint32_t s = 0; s < liveChannelSlots; ++s) new (&liveSlot(s)) LiveSlotHeader{};
+
+	std::cout << "live channel: publishing " << bytes / 1024.0 << " KB as " << name << std::endl;
+	return true;
+}
+
+void publishLiveFrame(const uint64_t& frame)
+{
+	if (!liveMemory) return;
+
+	LiveChannelHeader& header = *reinterpret_cast<LiveChannelHeader*>(liveMemory->data());
+	const uint64_t published = header.published.load(std::memory_order_relaxed);
+	LiveSlotHeader& slot = liveSlot(published);
+
+	const uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+	slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	unsigned char* payload = reinterpret_cast<unsigned char*>(&slot) + sizeof(LiveSlotHeader);
+	slot.frame = frame;
+	std::memcpy(payload, particles.centers, PARTICLES_NUMBER * sizeof(vec2));
+	std::memcpy(payload + PARTICLES_NUMBER * sizeof(vec2), particles.dir, PARTICLES_NUMBER * sizeof(vec2));
+
+	slot.sequence.store(sequence + 2, std::memory_order_release);
+	header.published.store(published + 1, std::memory_order_release);
+}
+
+void closeLiveChannel()
+{
+	if (!liveMemory) return;
+
+	LiveChannelHeader& header = *reinterpret_cast<LiveChannelHeader*>(liveMemory->data());
+	header.closed.store(1, std::memory_order_release);
+	std::cout << "live channel: " << header.published.load(std::memory_order_relaxed) << " frames published" << std::endl;
+
+	liveMemory.reset();
+}
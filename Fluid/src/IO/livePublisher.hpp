@@ -0,0 +1,15 @@
+#ifndef LIVE_PUBLISHER
+#define LIVE_PUBLISHER
+
+#include <cstdint>
+
+// Solver side of the live channel. Publishing copies the positions and
+// velocities into the next ring slot of the shared block, a few microseconds
+// per frame and never waiting for readers. Names follow the POSIX form
+// "/name".
+bool openLiveChannel(const char* name);
+void publishLiveFrame(const uint64_t& frame);
+// marks the channel closed for attached readers and removes the name
+void closeLiveChannel();
+
+#endif
@@ -0,0 +1,78 @@
+#include "liveReader.hpp"
+
+#include <cstring>
+
+LiveReader::LiveReader(const char* name) : memory(name, SharedAccess::Read)
+{
+	if (memory.size() < sizeof(LiveChannelHeader)) return;
+
+	const LiveChannelHeader* candidate = reinterpret_cast<const LiveChannelHeader*>(memory.data());
+	if (std::memcmp(candidate->magic, liveChannelMagic, sizeof(liveChannelMagic)) != 0
+		|| candidate->version != liveChannelVersion
+		|| candidate->headerSize != sizeof(LiveChannelHeader)
+		|| candidate->slots == 0
+		|| candidate->slotBytes < liveSlotBytes(candidate->particles)
+		|| memory.size() < candidate->firstSlot + candidate->slots * candidate->slotBytes)
+	{
+		return;
+	}
+	header = candidate;
+}
+
+bool LiveReader::latest(LiveFrame& frame) const
+{
+	if (!header) return false;
+
+	for (int attempt = 0; attempt < liveReadAttempts; ++attempt)
+	{
+		const uint64_t published = header->published.load(std::memory_order_acquire);
+		if (published == 0) return false;
+
+		// An odd sequence means the slot is being written, or the publisher died
+		// inside the write and it stays odd; the previous slot holds the frame before.
+		for (uint64_t back = 0; back < 2 && back < published; ++back)
+		{
+			const unsigned char* base = memory.data() + header->firstSlot + (published - 1 - back) % header->slots * header->slotBytes;
+			const LiveSlotHeader* slot = reinterpret_cast<const LiveSlotHeader*>(base);
+
+			const uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+			if (sequence & 1) continue;
+
+			frame.frame = slot->frame;
+			frame.positions = reinterpret_cast<const float*>(base + sizeof(LiveSlotHeader));
+			frame.velocities = frame.positions + 2 * header->particles;
+			frame.sequence = sequence;
+			frame.slot = slot;
+
+			if (valid(frame)) return true;
+		}
+	}
+	return false;
+}
+
+bool LiveReader::valid(const LiveFrame& frame) const
+{
+	std::atomic_thread_fence(std::memory_order_acquire);
+	return frame.slot && frame.slot->sequence.load(std::memory_order_relaxed) == frame.sequence;
+}
+
+bool LiveReader::copyLatest(float* positions, float* velocities, uint64_t* frameNumber) const
+{
+	const size_t bytes = 2 * static_cast<size_t>(header ? header->particles : 0) * sizeof(float);
+	LiveFrame frame;
+
+	for (int attempt = 0; attempt < liveReadAttempts; ++attempt)
+	{
+		if (!latest(frame)) return false;
+
+		if (positions) std::memcpy(positions, frame.positions, bytes);
+		if (velocities) std::memcpy(velocities, frame.velocities, bytes);
+
+		if (valid(frame))
+		{
+			if (frameNumber) *frameNumber = frame.frame;
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,57 @@
+#ifndef LIVE_READER
+#define LIVE_READER
+
+#include "liveChannel.hpp"
+#include "sharedMemory.hpp"
+
+// Consumer side of the live channel, for analysis tools and viewers in other
+// processes. Depends only on liveChannel.hpp and sharedMemory, so it builds
+// without the solver.
+//
+//     LiveReader reader("/fluid");
+//     LiveFrame frame;
+//     if (reader.latest(frame))
+//     {
+//         use(frame.positions);             // straight from shared memory
+//         if (!reader.valid(frame)) ...     // overwritten meanwhile, discard
+//     }
+
+// reads give up after this many overtaken or half written frames
+static constexpr int liveReadAttempts = 64;
+
+struct LiveFrame
+{
+	uint64_t frame = 0;
+	const float* positions = nullptr;	// x, y pairs
+	const float* velocities = nullptr;
+	uint64_t sequence = 0;
+	const LiveSlotHeader* slot = nullptr;
+};
+
+class LiveReader
+{
+public:
+	// connected() is false when the channel does not exist or does not match
+	explicit LiveReader(const char* name);
+
+	bool connected() const { return header != nullptr; }
+	uint32_t particles() const { return header->particles; }
+	// the solver shut down, the last frames stay readable
+	bool closed() const { return header->closed.load(std::memory_order_acquire) != 0; }
+	uint64_t published() const { return header->published.load(std::memory_order_acquire); }
+
+	// zero copy view of the newest complete frame, false before the first one
+	// and when no complete frame turns up, e.g. after the publisher died mid write
+	bool latest(LiveFrame& frame) const;
+	// true while the frame has not been overwritten, check after using it
+	bool valid(const LiveFrame& frame) const;
+	// copies the newest frame, retrying when the solver overtakes the copy;
+	// either output may be null, they are unspecified when it returns false
+	bool copyLatest(float* positions, float* velocities, uint64_t* frame = nullptr) const;
+
+private:
+	SharedMemory memory;
+	const LiveChannelHeader* header = nullptr;
+};
+
+#endif
@@ -0,0 +1,57 @@
+#include "mappedFile.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+
+MappedFile::MappedFile(const char* path)
+{
+	HANDLE handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (handle == INVALID_HANDLE_VALUE) return;
+	file = handle;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(handle, &fileSize) || fileSize.QuadPart == 0) return;
+
+	mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping) return;
+
+	bytes = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	if (bytes) length = static_cast<size_t>(fileSize.QuadPart);
+}
+MappedFile::~MappedFile()
+{
+	if (bytes) UnmapViewOfFile(bytes);
+	if (mapping) CloseHandle(mapping);
+	if (file) CloseHandle(file);
+}
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const char* path)
+{
+	const int fd = open(path, O_RDONLY);
+	if (fd < 0) return;
+
+	struct stat info;
+	if (fstat(fd, &info) == 0 && info.st_size > 0)
+	{
+		void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+		if (view != MAP_FAILED)
+		{
+			bytes = static_cast<const unsigned char*>(view);
+			length = static_cast<size_t>(info.st_size);
+		}
+	}
+	// the mapping keeps its own reference to the file
+	close(fd);
+}
+MappedFile::~MappedFile()
+{
+	if (bytes) munmap(const_cast<unsigned char*>(bytes), length);
+}
+#endif
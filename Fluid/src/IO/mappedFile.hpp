@@ -0,0 +1,30 @@
+#ifndef MAPPED_FILE
+#define MAPPED_FILE
+
+#include <cstddef>
+
+// Read-only view of a whole file mapped into memory. The mapping is released
+// when the object goes out of scope; data() is null when opening failed.
+class MappedFile
+{
+public:
+	explicit MappedFile(const char* path);
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	const unsigned char* data() const { return bytes; }
+	size_t size() const { return length; }
+
+private:
+	const unsigned char* bytes = nullptr;
+	size_t length = 0;
+
+#ifdef _WIN32
+	void* file = nullptr;
+	void* mapping = nullptr;
+#endif
+};
+
+#endif
@@ -0,0 +1,235 @@
+#include "pointCloud.hpp"
+#include "../PBF/particles.hpp"
+#include "../IISPH/iisph.hpp"
+#include "../Scene/scene.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <string>
+
+static constexpr const char* pressureName = solver == Solver::IISPH ? "pressure" : "lambda";
+
+// owned by the I/O thread while the writer runs, apart from the encoding counters
+struct PointCloudOutput
+{
+	PointCloudFormat format = PointCloudFormat::VTK;
+	std::string prefix;
+	std::string extension;
+
+	uint64_t files = 0;
+	uint64_t failures = 0;
+
+	uint64_t encoded = 0;
+	double encodeTime = 0.0;
+};
+
+static std::unique_ptr<PointCloudOutput> pointCloudOutput;
+static std::unique_ptr<AsyncWriter> pointCloudWriter;
+
+static float particleDensity(const int& i)
+{
+	if constexpr (solver == Solver::IISPH) return densities[i];
+	else return (densityErrors[i] + 1.0f) * targetDensity;
+}
+static float particlePressure(const int& i)
+{
+	if constexpr (solver == Solver::IISPH) return pressures[i];
+	else return lambdas[i];
+}
+
+static void storeBigEndian(unsigned char* out, const uint32_t& value)
+{
+	out[0] = static_cast<unsigned char>(value >> 24);
+	out[1] = static_cast<unsigned char>(value >> 16);
+	out[2] = static_cast<unsigned char>(value >> 8);
+	out[3] = static_cast<unsigned char>(value);
+}
+static void storeBigEndian(unsigned char* out, const float& value)
+{
+	storeBigEndian(out, std::bit_cast<uint32_t>(value));
+}
+
+// one chunk per thread, unless that leaves too little work to split
+static int chunkSize()
+{
+	return std::max<int>(pointCloudMinChunk, (PARTICLES_NUMBER + scene.threads - 1) / scene.threads);
+}
+
+static size_t putText(unsigned char* out, size_t offset, const std::string& text)
+{
+	std::memcpy(out + offset, text.data(), text.size());
+	return offset + text.size();
+}
+
+// Legacy VTK keeps every attribute in its own block, each chunk fills its
+// range of all of them.
+static size_t encodeVTK(const uint64_t& frame, unsigned char* out)
+{
+	const std::string n = std::to_string(PARTICLES_NUMBER);
+	size_t offset = putText(out, 0, "# vtk DataFile Version 3.0\nFluid frame " + std::to_string(frame)
+		+ "\nBINARY\nDATASET POLYDATA\nPOINTS " + n + " float\n");
+
+	const size_t points = offset;
+	offset = putText(out, points + 12 * PARTICLES_NUMBER, "\nVERTICES " + n + " " + std::to_string(2 * PARTICLES_NUMBER) + "\n");
+	const size_t cells = offset;
+	offset = putText(out, cells + 8 * PARTICLES_NUMBER, "\nPOINT_DATA " + n + "\nVECTORS velocity float\n");
+	const size_t velocities = offset;
+	offset = putText(out, velocities + 12 * PARTICLES_NUMBER, "\nSCALARS density float 1\nLOOKUP_TABLE default\n");
+	const size_t density = offset;
+	offset = putText(out, density + 4 * PARTICLES_NUMBER, "\nSCALARS " + std::string(pressureName) + " float 1\nLOOKUP_TABLE default\n");
+	const size_t pressure = offset;
+	offset = putText(out, pressure + 4 * PARTICLES_NUMBER, "\n");
+
+	const int chunk = chunkSize();
+	const int chunks = (PARTICLES_NUMBER + chunk - 1) / chunk;
+
+	#pragma omp parallel for num_threads(scene.threads) schedule(static)
+	for (int c = 0; c < chunks; ++c)
+	{
+		const int end = std::min<int>(c * chunk + chunk, PARTICLES_NUMBER);
+
+		for (int i = c * chunk; i < end; ++i)
+		{
+			unsigned char* point = out + points + 12 * i;
+			storeBigEndian(point, particles.centers[i].x);
+			storeBigEndian(point + 4, particles.centers[i].y);
+			storeBigEndian(point + 8, 0.0f);
+
+			storeBigEndian(out + cells + 8 * i, 1U);
+			storeBigEndian(out + cells + 8 * i + 4, static_cast<uint32_t>(i));
+
+			unsigned char* velocity = out + velocities + 12 * i;
+			storeBigEndian(velocity, particles.dir[i].x);
+			storeBigEndian(velocity + 4, particles.dir[i].y);
+			storeBigEndian(velocity + 8, 0.0f);
+
+			storeBigEndian(out + density + 4 * i, particleDensity(i));
+			storeBigEndian(out + pressure + 4 * i, particlePressure(i));
+		}
+	}
+	return offset;
+}
+
+// PLY interleaves the attributes, one record per particle.
+static size_t encodePLY(const uint64_t& frame, unsigned char* out)
+{
+	const char* byteOrder = std::endian::native == std::endian::little ? "binary_little_endian" : "binary_big_endian";
+	const size_t body = putText(out, 0, std::string("ply\nformat ") + byteOrder + " 1.0\ncomment Fluid frame " + std::to_string(frame)
+		+ "\nelement vertex " + std::to_string(PARTICLES_NUMBER)
+		+ "\nproperty float x\nproperty float y\nproperty float z"
+		+ "\nproperty float vx\nproperty float vy\nproperty float vz"
+		+ "\nproperty float density\nproperty float " + pressureName + "\nend_header\n");
+
+	const int chunk = chunkSize();
+	const int chunks = (PARTICLES_NUMBER + chunk - 1) / chunk;
+
+	#pragma omp parallel for num_threads(scene.threads) schedule(static)
+	for (int c = 0; c < chunks; ++c)
+	{
+		const int end = std::min<int>(c * chunk + chunk, PARTICLES_NUMBER);
+
+		for (int i = c * chunk; i < end; ++i)
+		{
+			const float record[8] = {
+				particles.centers[i].x, particles.centers[i].y, 0.0f,
+				particles.dir[i].x, particles.dir[i].y, 0.0f,
+				particleDensity(i), particlePressure(i) };
+			std::memcpy(out + body + sizeof(record) * i, record, sizeof(record));
+		}
+	}
+	return body + 32 * static_cast<size_t>(PARTICLES_NUMBER);
+}
+
+size_t encodePointCloud(const PointCloudFormat& format, const uint64_t& frame, unsigned char* out)
+{
+	return format == PointCloudFormat::VTK ? encodeVTK(frame, out) : encodePLY(frame, out);
+}
+
+static void writePointCloudBuffer(WriteBuffer& buffer, void* context)
+{
+	PointCloudOutput& output = *static_cast<PointCloudOutput*>(context);
+
+	char name[32];
+	std::snprintf(name, sizeof(name), "_%06llu.", static_cast<unsigned long long>(buffer.tag));
+	const std::string path = output.prefix + name + output.extension;
+
+	std::FILE* file = std::fopen(path.c_str(), "wb");
+	const bool written = file && std::fwrite(buffer.data.data(), 1, buffer.size, file) == buffer.size;
+	if (file) std::fclose(file);
+
+	if (!written)
+	{
+		// one message, a full disk would otherwise report every frame
+		if (output.failures++ == 0) std::cerr << "point cloud: writing " << path << " failed" << std::endl;
+		return;
+	}
+	++output.files;
+}
+
+bool openPointCloudExport(const char* format, const char* prefix)
+{
+	closePointCloudExport();
+
+	auto output = std::make_unique<PointCloudOutput>();
+	if (std::strcmp(format, "vtk") == 0) output->format = PointCloudFormat::VTK;
+	else if (std::strcmp(format, "ply") == 0) output->format = PointCloudFormat::PLY;
+	else
+	{
+		std::cerr << "point cloud: unknown format " << format << std::endl;
+		return false;
+	}
+	output->prefix = prefix;
+	output->extension = format;
+
+	std::error_code error;
+	const std::filesystem::path directory = std::filesystem::path(prefix).parent_path();
+	if (!directory.empty()) std::filesystem::create_directories(directory, error);
+	if (error)
+	{
+		std::cerr << "point cloud: cannot create " << directory.string() << std::endl;
+		return false;
+	}
+
+	pointCloudOutput = std::move(output);
+	pointCloudWriter = std::make_unique<AsyncWriter>(pointCloudQueueDepth, pointCloudMaxBytes, pointCloudBackpressure,
+		writePointCloudBuffer, pointCloudOutput.get());
+	return true;
+}
+
+void exportPointCloud(const uint64_t& frame)
+{
+	if (!pointCloudWriter) return;
+
+	WriteBuffer* buffer = pointCloudWriter->acquire();
+	if (!buffer) return;
+
+	const auto start = std::chrono::steady_clock::now();
+	buffer->size = encodePointCloud(pointCloudOutput->format, frame, buffer->data.data());
+	pointCloudOutput->encodeTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	++pointCloudOutput->encoded;
+
+	buffer->tag = frame;
+	pointCloudWriter->submit(buffer);
+}
+
+void closePointCloudExport()
+{
+	if (!pointCloudWriter) return;
+
+	pointCloudWriter->flush();
+	pointCloudWriter->report("point cloud");
+	pointCloudWriter.reset();
+
+	const PointCloudOutput& output = *pointCloudOutput;
+	std::cout << "point cloud: " << output.files << " " << output.extension << " files, "
+		<< output.failures << " failed, encoding " << (output.encoded ? output.encodeTime * 1000.0 / output.encoded : 0.0)
+		<< " ms per frame" << std::endl;
+
+	pointCloudOutput.reset();
+}
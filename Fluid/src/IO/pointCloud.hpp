@@ -0,0 +1,36 @@
+#ifndef POINT_CLOUD
+#define POINT_CLOUD
+
+#include "asyncWriter.hpp"
+#include "../settings.hpp"
+
+// Frames as point clouds for external viewers, one file per frame with the
+// position, velocity, density and the solver's pressure variable (lambda for
+// PBF, pressure for IISPH) of every particle:
+//
+//     VTK  legacy binary POLYDATA, big endian, one vertex cell per particle
+//     PLY  binary in the host byte order, one vertex element per particle
+//
+// Both layouts have a fixed size per particle, so the solver thread encodes
+// chunks of particles straight into their place in a pooled buffer in
+// parallel and only the file writes run on the I/O thread.
+
+enum class PointCloudFormat { VTK, PLY };
+
+static constexpr int          pointCloudQueueDepth   = 4;
+static constexpr Backpressure pointCloudBackpressure = Backpressure::Block;
+static constexpr int          pointCloudMinChunk     = 64;	// particles per encoding task at least
+
+// the headers are text of at most this size
+static constexpr size_t pointCloudHeaderBytes = 512;
+static constexpr size_t pointCloudMaxBytes = pointCloudHeaderBytes + PARTICLES_NUMBER * 40;
+
+// encodes the current state, returns the size
+size_t encodePointCloud(const PointCloudFormat& format, const uint64_t& frame, unsigned char* out);
+
+// format is "vtk" or "ply", files are named <prefix>_<frame>.<format>
+bool openPointCloudExport(const char* format, const char* prefix);
+void exportPointCloud(const uint64_t& frame);
+void closePointCloudExport();
+
+#endif
@@ -0,0 +1,198 @@
+#include "replay.hpp"
+#include "mappedFile.hpp"
+
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+struct Replay
+{
+	std::unique_ptr<MappedFile> file;
+	TrajectoryHeader header;
+	const TrajectoryIndexEntry* index = nullptr;
+	std::vector<TrajectoryIndexEntry> rebuiltIndex;
+	int count = 0;
+
+	// compressed files only
+	std::unique_ptr<TrajectoryCodecState> codec;
+	std::vector<vec2> positions;
+	std::vector<vec2> velocities;
+	int decoded = -1;
+};
+
+static Replay replay;
+
+static bool validReplayHeader(const TrajectoryHeader& header, const char* path)
+{
+	if (std::memcmp(header.magic, "FLUIDTR", 8) != 0 || header.version != trajectoryVersion)
+	{
+		std::cerr << "replay: " << path << " is not a version " << trajectoryVersion << " trajectory" << std::endl;
+		return false;
+	}
+	if (header.particles != PARTICLES_NUMBER)
+	{
+		std::cerr << "replay: " << path << " holds " << header.particles << " particles, the build draws " << PARTICLES_NUMBER << std::endl;
+		return false;
+	}
+	if (header.codec == static_cast<uint32_t>(TrajectoryCodec::Compressed)
+		&& (header.positionStep != trajectoryPositionStep || header.velocityStep != trajectoryVelocityStep
+			|| header.boxMarginX != BOXMARGINX || header.boxMarginY != BOXMARGINY))
+	{
+		std::cerr << "replay: " << path << " was quantised differently than this build decodes" << std::endl;
+		return false;
+	}
+	if (header.codec > static_cast<uint32_t>(TrajectoryCodec::Compressed))
+	{
+		std::cerr << "replay: " << path << " uses unknown codec " << header.codec << std::endl;
+		return false;
+	}
+	return true;
+}
+
+static bool validFrame(const TrajectoryIndexEntry& entry)
+{
+	const size_t size = replay.file->size();
+	if (entry.offset > size || size - entry.offset < sizeof(TrajectoryFrame) + entry.bytes) return false;
+
+	return replay.header.codec == static_cast<uint32_t>(TrajectoryCodec::Compressed) || entry.bytes == trajectoryRawBytes;
+}
+
+// a run that did not close its trajectory has no index, the records still chain
+static void rebuildReplayIndex()
+{
+	const unsigned char* data = replay.file->data();
+	const size_t size = replay.file->size();
+	uint64_t offset = replay.header.headerSize;
+
+	while (offset + sizeof(TrajectoryFrame) <= size)
+	{
+		TrajectoryFrame record;
+		std::memcpy(&record, data + offset, sizeof(TrajectoryFrame));
+
+		TrajectoryIndexEntry entry = { record.frame, offset, static_cast<uint32_t>(record.bytes), 1 };
+		if (record.bytes > UINT32_MAX || !validFrame(entry)) break;
+
+		if (replay.header.codec == static_cast<uint32_t>(TrajectoryCodec::Compressed))
+		{
+			entry.keyframe = isTrajectoryKeyframe(data + offset + sizeof(TrajectoryFrame)) ? 1U : 0U;
+		}
+		replay.rebuiltIndex.push_back(entry);
+		offset += sizeof(TrajectoryFrame) + record.bytes;
+	}
+
+	replay.index = replay.rebuiltIndex.data();
+	replay.count = static_cast<int>(replay.rebuiltIndex.size());
+}
+
+bool openReplay(const char* path)
+{
+	closeReplay();
+
+	replay.file = std::make_unique<MappedFile>(path);
+	if (!replay.file->data() || replay.file->size() < sizeof(TrajectoryHeader))
+	{
+		std::cerr << "replay: cannot map " << path << std::endl;
+		closeReplay();
+		return false;
+	}
+
+	std::memcpy(&replay.header, replay.file->data(), sizeof(TrajectoryHeader));
+	if (!validReplayHeader(replay.header, path))
+	{
+		closeReplay();
+		return false;
+	}
+
+	const TrajectoryHeader& header = replay.header;
+	const size_t size = replay.file->size();
+	const bool indexed = header.frameCount > 0 && header.indexOffset <= size
+		&& (size - header.indexOffset) / sizeof(TrajectoryIndexEntry) >= header.frameCount;
+
+	if (indexed)
+	{
+		const unsigned char* index = replay.file->data() + header.indexOffset;
+		replay.count = static_cast<int>(header.frameCount);
+
+		// files written before the index was padded are copied out rather than read misaligned
+		if (reinterpret_cast<uintptr_t>(index) % alignof(TrajectoryIndexEntry) == 0)
+		{
+			replay.index = reinterpret_cast<const TrajectoryIndexEntry*>(index);
+		}
+		else
+		{
+			replay.rebuiltIndex.resize(replay.count);
+			std::memcpy(replay.rebuiltIndex.data(), index, replay.count * sizeof(TrajectoryIndexEntry));
+			replay.index = replay.rebuiltIndex.data();
+		}
+
+		for (int n = 0; n < replay.count; ++n)
+		{
+			if (validFrame(replay.index[n])) continue;
+
+			std::cerr << "replay: frame " << n << " of " << path << " lies outside the file" << std::endl;
+			closeReplay();
+			return false;
+		}
+	}
+	else rebuildReplayIndex();
+
+	if (replay.count == 0)
+	{
+		std::cerr << "replay: " << path << " holds no frames" << std::endl;
+		closeReplay();
+		return false;
+	}
+
+	if (header.codec == static_cast<uint32_t>(TrajectoryCodec::Compressed))
+	{
+		replay.codec = std::make_unique<TrajectoryCodecState>();
+		replay.positions.resize(PARTICLES_NUMBER);
+		replay.velocities.resize(PARTICLES_NUMBER);
+	}
+
+	std::cout << "replay: " << replay.count << " frames from " << path << (indexed ? "" : ", index rebuilt") << std::endl;
+	return true;
+}
+
+void closeReplay()
+{
+	replay = Replay();
+}
+
+int replayFrameCount()
+{
+	return replay.count;
+}
+uint64_t replayFrameNumber(const int& n)
+{
+	return replay.index[n].frame;
+}
+
+const vec2* replayPositions(const int& n)
+{
+	const unsigned char* data = replay.file->data();
+	const auto payload = [&](const int& k) { return data + replay.index[k].offset + sizeof(TrajectoryFrame); };
+
+	if (!replay.codec) return reinterpret_cast<const vec2*>(payload(n));
+	if (n == replay.decoded) return replay.positions.data();
+
+	int first = n;
+	while (first > 0 && !replay.index[first].keyframe) --first;
+
+	// stepping forward inside the current keyframe group continues from the last decoded frame
+	if (replay.decoded >= first && replay.decoded < n) first = replay.decoded + 1;
+
+	for (int k = first; k <= n; ++k)
+	{
+		if (!decodeTrajectoryFrame(*replay.codec, payload(k), replay.index[k].bytes, replay.positions.data(), replay.velocities.data()))
+		{
+			std::cerr << "replay: frame " << k << " cannot be decoded" << std::endl;
+			replay.codec->history = 0;
+			replay.decoded = -1;
+			return replay.positions.data();
+		}
+		replay.decoded = k;
+	}
+	return replay.positions.data();
+}
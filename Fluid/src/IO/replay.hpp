@@ -0,0 +1,20 @@
+#ifndef REPLAY
+#define REPLAY
+
+#include "trajectory.hpp"
+
+// Plays back a trajectory file instead of simulating. The file is mapped and
+// frames are found through its index, read from the end of the file or, when
+// the run was cut short, rebuilt by walking the frame records once. Raw
+// frames are handed out as pointers into the mapping, compressed frames are
+// decoded from the closest keyframe at or before the requested one.
+
+bool openReplay(const char* path);
+void closeReplay();
+
+int replayFrameCount();
+uint64_t replayFrameNumber(const int& n);
+// positions of the n-th stored frame, valid until the next call
+const vec2* replayPositions(const int& n);
+
+#endif
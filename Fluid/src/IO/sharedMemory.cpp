@@ -0,0 +1,75 @@
+#include "sharedMemory.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+
+SharedMemory::SharedMemory(const char* name, const SharedAccess& access, const size_t& bytes)
+{
+	if (access == SharedAccess::Create)
+	{
+		const unsigned long long size = bytes;
+		mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+			static_cast<DWORD>(size >> 32), static_cast<DWORD>(size), name);
+	}
+	else mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, name);
+	if (!mapping) return;
+
+	void* view = MapViewOfFile(mapping, access == SharedAccess::Create ? FILE_MAP_ALL_ACCESS : FILE_MAP_READ, 0, 0, 0);
+	if (!view) return;
+
+	MEMORY_BASIC_INFORMATION region;
+	if (access == SharedAccess::Create) length = bytes;
+	else if (VirtualQuery(view, &region, sizeof(region))) length = region.RegionSize;
+	this->bytes = static_cast<unsigned char*>(view);
+}
+SharedMemory::~SharedMemory()
+{
+	if (bytes) UnmapViewOfFile(bytes);
+	if (mapping) CloseHandle(mapping);
+}
+#else
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+SharedMemory::SharedMemory(const char* name, const SharedAccess& access, const size_t& bytes)
+{
+	int fd;
+	if (access == SharedAccess::Create)
+	{
+		// a block left behind by a crashed run is replaced, its readers keep the old one
+		shm_unlink(name);
+		fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0644);
+		if (fd < 0) return;
+
+		std::strncpy(this->name, name, sizeof(this->name) - 1);
+		if (ftruncate(fd, static_cast<off_t>(bytes)) == 0) length = bytes;
+	}
+	else
+	{
+		fd = shm_open(name, O_RDONLY, 0);
+		if (fd < 0) return;
+
+		struct stat info;
+		if (fstat(fd, &info) == 0) length = static_cast<size_t>(info.st_size);
+	}
+
+	if (length > 0)
+	{
+		const int protection = access == SharedAccess::Create ? PROT_READ | PROT_WRITE : PROT_READ;
+		void* view = mmap(nullptr, length, protection, MAP_SHARED, fd, 0);
+		if (view != MAP_FAILED) this->bytes = static_cast<unsigned char*>(view);
+		else length = 0;
+	}
+	close(fd);
+}
+SharedMemory::~SharedMemory()
+{
+	if (bytes) munmap(bytes, length);
+	if (name[0]) shm_unlink(name);
+}
+#endif
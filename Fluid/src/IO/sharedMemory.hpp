@@ -0,0 +1,37 @@
+#ifndef SHARED_MEMORY
+#define SHARED_MEMORY
+
+#include <cstddef>
+
+// A named block of memory other processes on the node can map: a POSIX
+// shared memory object, a pagefile backed file mapping on Windows. The
+// creator maps it read-write and removes the name when it goes out of scope,
+// processes that still have it mapped keep their view. data() is null when
+// creating or opening failed.
+enum class SharedAccess { Create, Read };
+
+class SharedMemory
+{
+public:
+	// bytes is the size to create, an opened block reports its own size
+	SharedMemory(const char* name, const SharedAccess& access, const size_t& bytes = 0);
+	~SharedMemory();
+
+	SharedMemory(const SharedMemory&) = delete;
+	SharedMemory& operator=(const SharedMemory&) = delete;
+
+	unsigned char* data() const { return bytes; }
+	size_t size() const { return length; }
+
+private:
+	unsigned char* bytes = nullptr;
+	size_t length = 0;
+
+#ifdef _WIN32
+	void* mapping = nullptr;
+#else
+	char name[256] = {};
+#endif
+};
+
+#endif
@@ -0,0 +1,137 @@
+#include "stateCache.hpp"
+#include "checkpoint.hpp"
+#include "../PBF/particles.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+
+using Clock = std::chrono::steady_clock;
+
+struct Fnv1a
+{
+	uint64_t value = 14695981039346656037ull;
+
+	void bytes(const void* data, const size_t& size)
+	{
+		const unsigned char* p = static_cast<const unsigned char*>(data);
+		for (size_t i = 0; i < size; ++i)
+		{
+			value ^= p[i];
+			value *= 1099511628211ull;
+		}
+	}
+	template <typename T> void add(const T& v) { bytes(&v, sizeof(T)); }
+	// with the length, so neighbouring strings cannot trade characters
+	void add(const std::string& text)
+	{
+		add(static_cast<uint64_t>(text.size()));
+		bytes(text.data(), text.size());
+	}
+};
+
+uint64_t settledStateKey(const SceneConfig& c)
+{
+	Fnv1a hash;
+	hash.add(stateCacheVersion);
+
+	hash.add(PARTICLES_NUMBER);
+	hash.add(BOXWIDTH);
+	hash.add(BOXHEIGHT);
+	hash.add(BOXMARGINX);
+	hash.add(BOXMARGINY);
+	hash.add(scale);
+	hash.add(area);
+	hash.add(radius);
+	hash.add(mass);
+	hash.add(targetDensity);
+	hash.add(solver);
+	hash.add(densityKernel);
+	hash.add(gradientKernel);
+	hash.add(tabulatedKernels);
+	hash.add(sleepingParticles);
+	hash.add(multirateStepping);
+	hash.add(multirateLevels);
+	hash.add(pairwiseEvaluation);
+	hash.add(batchedGather);
+
+	if constexpr (solver == Solver::IISPH)
+	{
+		hash.add(c.iisphDt);
+		hash.add(c.cfl);
+		hash.add(c.omega);
+		hash.add(c.xsphViscosity);
+		hash.add(c.maxDensityError);
+		hash.add(c.minIterations);
+		hash.add(c.maxIterations);
+		hash.add(c.gravity);
+	}
+	else
+	{
+		hash.add(c.dt);
+		hash.add(c.resistance);
+		hash.add(c.gravity);
+		hash.add(c.viscosity);
+		hash.add(c.relaxation);
+		hash.add(c.deltaQ);
+		hash.add(c.iterations);
+		hash.add(c.collisionPenalty);
+		hash.add(c.tensileK);
+		hash.add(c.tensileN);
+	}
+
+	hash.add(c.layout);
+	hash.add(c.seed);
+	hash.add(c.spacing);
+	hash.add(c.fillWidth);
+	hash.add(c.jitter);
+	hash.add(c.settleFrames);
+
+	// the contents, an edited file is a different layout under the same name
+	if (c.layout == "file")
+	{
+		std::ifstream file(c.layoutFile, std::ios::binary);
+		hash.add(std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()));
+	}
+	return hash.value;
+}
+
+bool prepareInitialState()
+{
+	if (scene.settleFrames == 0) return initParticles();
+
+	const bool cached = scene.cache && scene.seed != 0;
+	char name[32];
+	std::snprintf(name, sizeof(name), "%016llx.fcp", static_cast<unsigned long long>(settledStateKey(scene)));
+	const std::filesystem::path path = std::filesystem::path(scene.cacheDirectory) / name;
+
+	const Clock::time_point start = Clock::now();
+
+	std::error_code error;
+	if (cached && std::filesystem::exists(path, error) && loadCheckpoint(path.string().c_str()))
+	{
+		std::cout << "initial state: settled state " << path.string() << " loaded in "
+			<< std::chrono::duration<double, std::milli>(Clock::now() - start).count() << " ms" << std::endl;
+		return true;
+	}
+
+	if (!initParticles()) return false;
+	for (int f = 0; f < scene.settleFrames; ++f) stepSimulation();
+
+	std::cout << "initial state: settled " << scene.settleFrames << " frames in "
+		<< std::chrono::duration<double>(Clock::now() - start).count() << " s" << std::endl;
+
+	if (!cached) return true;
+
+	// a failed store only costs the next run the settling again
+	std::filesystem::create_directories(scene.cacheDirectory, error);
+	if (!error && saveCheckpoint(path.string().c_str(), static_cast<uint64_t>(scene.settleFrames)))
+	{
+		std::cout << "initial state: cached as " << path.string() << std::endl;
+	}
+	return true;
+}
@@ -0,0 +1,24 @@
+#ifndef STATE_CACHE
+#define STATE_CACHE
+
+#include "../Scene/scene.hpp"
+
+#include <cstdint>
+
+// Settled initial states. With settle_frames set, a run starts from the
+// [init] layout simulated for that many frames. The result is stored as a
+// checkpoint named after a hash of everything it depends on, the compiled
+// constants and kernels, the solver parameters and the layout, so a later
+// run with the same scene loads it instead of settling again. Changing any
+// of them changes the name; stale files are never read, only left behind.
+// A clock seeded layout is not reproducible and is never cached.
+
+static constexpr uint32_t stateCacheVersion = 1;
+
+// FNV-1a over the build constants and the scene parameters the state depends on
+uint64_t settledStateKey(const SceneConfig& config);
+
+// initParticles followed by settling for scene.settleFrames, through the cache
+bool prepareInitialState();
+
+#endif
@@ -0,0 +1,156 @@
+#include "trajectory.hpp"
+#include "../PBF/particles.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+static constexpr char trajectoryMagic[8] = { 'F', 'L', 'U', 'I', 'D', 'T', 'R', '\0' };
+
+// owned by the I/O thread while the writer runs
+struct TrajectoryOutput
+{
+	std::FILE* file = nullptr;
+	TrajectoryHeader header = {};
+	uint64_t offset = 0;
+	std::vector<TrajectoryIndexEntry> index;
+
+	TrajectoryCodecState codec;
+	std::vector<unsigned char> encoded;
+	uint64_t rawBytes = 0;
+	uint64_t payloadBytes = 0;
+	double encodeTime = 0.0;
+};
+
+static std::unique_ptr<TrajectoryOutput> trajectoryOutput;
+static std::unique_ptr<AsyncWriter> trajectoryWriter;
+
+static void writeTrajectoryBuffer(WriteBuffer& buffer, void* context)
+{
+	TrajectoryOutput& output = *static_cast<TrajectoryOutput*>(context);
+
+	const unsigned char* payload = buffer.data.data();
+	size_t bytes = trajectoryRawBytes;
+	bool keyframe = true;
+
+	if constexpr (trajectoryCodec == TrajectoryCodec::Compressed)
+	{
+		const vec2* positions = reinterpret_cast<const vec2*>(payload);
+		keyframe = output.index.size() % trajectoryKeyframeInterval == 0;
+
+		const auto start = std::chrono::steady_clock::now();
+		bytes = encodeTrajectoryFrame(output.codec, positions, positions + PARTICLES_NUMBER, keyframe, output.encoded.data());
+		output.encodeTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		payload = output.encoded.data();
+	}
+
+	const TrajectoryFrame record = { buffer.tag, bytes };
+	if (std::fwrite(&record, sizeof(TrajectoryFrame), 1, output.file) != 1
+		|| std::fwrite(payload, 1, bytes, output.file) != bytes)
+	{
+		std::cerr << "trajectory: writing frame " << buffer.tag << " failed" << std::endl;
+	}
+
+	output.index.push_back({ buffer.tag, output.offset, static_cast<uint32_t>(bytes), keyframe ? 1U : 0U });
+	output.offset += sizeof(TrajectoryFrame) + bytes;
+	output.rawBytes += trajectoryRawBytes;
+	output.payloadBytes += bytes;
+}
+
+bool openTrajectory(const char* path)
+{
+	closeTrajectory();
+
+	std::FILE* file = std::fopen(path, "wb");
+	if (!file)
+	{
+		std::cerr << "trajectory: cannot open " << path << std::endl;
+		return false;
+	}
+
+	trajectoryOutput = std::make_unique<TrajectoryOutput>();
+	TrajectoryOutput& output = *trajectoryOutput;
+	TrajectoryHeader& header = output.header;
+
+	std::memcpy(header.magic, trajectoryMagic, sizeof(trajectoryMagic));
+	header.version          = trajectoryVersion;
+	header.headerSize       = sizeof(TrajectoryHeader);
+	header.particles        = PARTICLES_NUMBER;
+	header.codec            = static_cast<uint32_t>(trajectoryCodec);
+	header.boxWidth         = BOXWIDTH;
+	header.boxHeight        = BOXHEIGHT;
+	header.boxMarginX       = BOXMARGINX;
+	header.boxMarginY       = BOXMARGINY;
+	header.scale            = scale;
+	header.positionStep     = trajectoryPositionStep;
+	header.velocityStep     = trajectoryVelocityStep;
+	header.keyframeInterval = trajectoryKeyframeInterval;
+
+	output.file = file;
+	output.offset = sizeof(TrajectoryHeader);
+	if constexpr (trajectoryCodec == TrajectoryCodec::Compressed) output.encoded.resize(trajectoryMaxEncodedBytes);
+
+	std::fwrite(&header, sizeof(TrajectoryHeader), 1, file);
+
+	trajectoryWriter = std::make_unique<AsyncWriter>(trajectoryQueueDepth, trajectoryRawBytes, trajectoryBackpressure,
+		writeTrajectoryBuffer, trajectoryOutput.get());
+	return true;
+}
+
+void recordTrajectoryFrame(const uint64_t& frame)
+{
+	if (!trajectoryWriter) return;
+
+	WriteBuffer* buffer = trajectoryWriter->acquire();
+	if (!buffer) return;
+
+	unsigned char* out = buffer->data.data();
+	std::memcpy(out, particles.centers, PARTICLES_NUMBER * sizeof(vec2));
+	std::memcpy(out + PARTICLES_NUMBER * sizeof(vec2), particles.dir, PARTICLES_NUMBER * sizeof(vec2));
+
+	buffer->size = trajectoryRawBytes;
+	buffer->tag = frame;
+	trajectoryWriter->submit(buffer);
+}
+
+void closeTrajectory()
+{
+	if (!trajectoryWriter) return;
+
+	trajectoryWriter->flush();
+	trajectoryWriter->report("trajectory");
+	trajectoryWriter.reset();
+
+	TrajectoryOutput& output = *trajectoryOutput;
+
+	// compressed payloads have any length, the index is padded to its alignment so replay can map it
+	static const unsigned char padding[alignof(TrajectoryIndexEntry)] = {};
+	const size_t pad = (alignof(TrajectoryIndexEntry) - output.offset % alignof(TrajectoryIndexEntry)) % alignof(TrajectoryIndexEntry);
+	std::fwrite(padding, 1, pad, output.file);
+	output.offset += pad;
+
+	output.header.frameCount = output.index.size();
+	output.header.indexOffset = output.offset;
+
+	std::fwrite(output.index.data(), sizeof(TrajectoryIndexEntry), output.index.size(), output.file);
+	std::fseek(output.file, 0, SEEK_SET);
+	std::fwrite(&output.header, sizeof(TrajectoryHeader), 1, output.file);
+	std::fclose(output.file);
+
+	if constexpr (trajectoryCodec == TrajectoryCodec::Compressed)
+	{
+		const double ratio = output.payloadBytes ? static_cast<double>(output.rawBytes) / output.payloadBytes : 0.0;
+		const double throughput = output.encodeTime > 0.0 ? output.rawBytes / (1024.0 * 1024.0) / output.encodeTime : 0.0;
+		const double bits = output.index.empty() ? 0.0 : (output.payloadBytes * 8.0) / (static_cast<double>(output.index.size()) * PARTICLES_NUMBER);
+
+		std::cout << "trajectory codec: " << output.index.size() << " frames, " << output.rawBytes / (1024.0 * 1024.0)
+			<< " MB raw to " << output.payloadBytes / (1024.0 * 1024.0) << " MB, ratio " << ratio
+			<< ", " << bits << " bits per particle, encoding " << throughput << " MB/s" << std::endl;
+	}
+
+	trajectoryOutput.reset();
+}
@@ -0,0 +1,68 @@
+#ifndef TRAJECTORY
+#define TRAJECTORY
+
+#include "asyncWriter.hpp"
+#include "trajectoryCodec.hpp"
+#include "../settings.hpp"
+
+// Per-frame positions and velocities streamed to a file. The solver thread
+// only copies the frame into a pooled buffer, encoding and writing happen on
+// the I/O thread of an AsyncWriter while the next frame is simulated.
+//
+// The file is a TrajectoryHeader followed by frames, each a TrajectoryFrame
+// record and its payload. A raw payload is the positions and then the
+// velocities of every particle, a compressed one is a trajectoryCodec frame.
+// Closing the file appends an index of every frame and patches the header,
+// a file without index can still be walked record by record.
+
+enum class TrajectoryCodec : uint32_t { Raw, Compressed };
+
+static constexpr int             trajectoryQueueDepth   = 8;
+static constexpr Backpressure    trajectoryBackpressure = Backpressure::Block;
+static constexpr TrajectoryCodec trajectoryCodec        = TrajectoryCodec::Compressed;
+
+static constexpr uint32_t trajectoryVersion = 2;
+
+struct TrajectoryHeader
+{
+	char     magic[8];
+	uint32_t version;
+	uint32_t headerSize;
+	uint32_t particles;
+	uint32_t codec;
+	uint32_t boxWidth;
+	uint32_t boxHeight;
+	uint32_t boxMarginX;
+	uint32_t boxMarginY;
+	float    scale;
+	float    positionStep;
+	float    velocityStep;
+	uint32_t keyframeInterval;
+
+	uint64_t frameCount;	// zero until the file is closed
+	uint64_t indexOffset;
+};
+
+struct TrajectoryFrame
+{
+	uint64_t frame;
+	uint64_t bytes;		// payload following the record
+};
+
+struct TrajectoryIndexEntry
+{
+	uint64_t frame;
+	uint64_t offset;	// of the TrajectoryFrame record
+	uint32_t bytes;
+	uint32_t keyframe;
+};
+
+static constexpr uint32_t trajectoryRawBytes = 2 * PARTICLES_NUMBER * sizeof(vec2);
+
+bool openTrajectory(const char* path);
+// a frame dropped by the backpressure policy leaves no gap marker, the frame numbers tell
+void recordTrajectoryFrame(const uint64_t& frame);
+// flushes the queue, writes the index, reports the writer statistics and closes the file
+void closeTrajectory();
+
+#endif
@@ -0,0 +1,301 @@
+#include "trajectoryCodec.hpp"
+#include "../NearestNeighborSearch/quadtree.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+static constexpr unsigned char keyframeFlag = 1;
+static constexpr size_t frameHeaderBytes = 4;
+
+static const vec2 origin(BOXMARGINX, BOXMARGINY);
+
+// LSB first, whole bytes are emitted as soon as they are complete
+struct BitWriter
+{
+	unsigned char* out;
+	size_t bytes = 0;
+	uint64_t acc = 0;
+	int count = 0;
+
+	void put(const uint32_t& value, const int& bits)
+	{
+		acc |= static_cast<uint64_t>(value) << count;
+		count += bits;
+		while (count >= 8)
+		{
+			out[bytes++] = static_cast<unsigned char>(acc);
+			acc >>= 8;
+			count -= 8;
+		}
+	}
+	void finish()
+	{
+		if (count > 0) out[bytes++] = static_cast<unsigned char>(acc);
+		acc = 0;
+		count = 0;
+	}
+};
+// reads zeros past the end and remembers it did
+struct BitReader
+{
+	const unsigned char* in;
+	size_t size;
+	size_t bytes = 0;
+	uint64_t acc = 0;
+	int count = 0;
+	uint64_t consumed = 0;
+
+	void refill()
+	{
+		while (count <= 56)
+		{
+			const uint64_t byte = bytes < size ? in[bytes] : 0;
+			acc |= byte << count;
+			bytes++;
+			count += 8;
+		}
+	}
+	uint32_t get(const int& bits)
+	{
+		if (bits == 0) return 0;
+		refill();
+
+		const uint32_t value = static_cast<uint32_t>(acc & ((uint64_t(1) << bits) - 1));
+		acc >>= bits;
+		count -= bits;
+		consumed += bits;
+		return value;
+	}
+	int unary()
+	{
+		refill();
+
+		const int ones = Min(std::countr_one(static_cast<uint32_t>(acc)), riceEscape);
+		const int bits = ones == riceEscape ? ones : ones + 1;
+		acc >>= bits;
+		count -= bits;
+		consumed += bits;
+		return ones;
+	}
+	bool overrun() const { return consumed > size * 8; }
+};
+
+inline uint32_t zigzag(const int32_t& v)
+{
+	return (static_cast<uint32_t>(v) << 1) ^ static_cast<uint32_t>(v >> 31);
+}
+inline int32_t unzigzag(const uint32_t& u)
+{
+	return static_cast<int32_t>(u >> 1) ^ -static_cast<int32_t>(u & 1);
+}
+
+static int riceCost(const uint32_t* values, const int& count, const int& k)
+{
+	int bits = 0;
+	for (int i = 0; i < count; ++i)
+	{
+		const uint32_t q = values[i] >> k;
+		bits += q < riceEscape ? static_cast<int>(q) + 1 + k : riceEscape + 32;
+	}
+	return bits;
+}
+
+// count values produced by value(k), Rice coded in blocks with the cheapest parameter
+// among the neighbors of log2 of the block mean
+template <typename Value>
+static void encodeChannel(BitWriter& writer, Value&& value)
+{
+	uint32_t block[riceBlock];
+
+	for (int first = 0; first < static_cast<int>(PARTICLES_NUMBER); first += riceBlock)
+	{
+		const int count = Min(riceBlock, static_cast<int>(PARTICLES_NUMBER) - first);
+
+		uint64_t sum = 0;
+		for (int i = 0; i < count; ++i)
+		{
+			block[i] = zigzag(value(first + i));
+			sum += block[i];
+		}
+
+		const uint64_t mean = sum / count;
+		const int guess = mean > 0 ? static_cast<int>(std::bit_width(mean)) - 1 : 0;
+
+		int k = guess;
+		int best = riceCost(block, count, guess);
+		for (int candidate = Max(guess - 1, 0); candidate <= Min(guess + 1, 31); ++candidate)
+		{
+			const int cost = riceCost(block, count, candidate);
+			if (cost < best) { best = cost; k = candidate; }
+		}
+
+		writer.put(k, 5);
+		for (int i = 0; i < count; ++i)
+		{
+			const uint32_t q = block[i] >> k;
+			if (q < riceEscape)
+			{
+				writer.put((1u << q) - 1, q + 1);
+				if (k > 0) writer.put(block[i] & ((1u << k) - 1), k);
+			}
+			else
+			{
+				writer.put((1u << riceEscape) - 1, riceEscape);
+				writer.put(block[i], 32);
+			}
+		}
+	}
+}
+template <typename Store>
+static void decodeChannel(BitReader& reader, Store&& store)
+{
+	for (int first = 0; first < static_cast<int>(PARTICLES_NUMBER); first += riceBlock)
+	{
+		const int count = Min(riceBlock, static_cast<int>(PARTICLES_NUMBER) - first);
+		const int k = static_cast<int>(reader.get(5));
+
+		for (int i = 0; i < count; ++i)
+		{
+			const int q = reader.unary();
+			const uint32_t u = q < riceEscape ? (static_cast<uint32_t>(q) << k) | reader.get(k) : reader.get(32);
+			store(first + i, unzigzag(u));
+		}
+	}
+}
+
+inline int32_t quantise(const float& value, const float& step)
+{
+	// NaNs and runaway particles are pinned instead of wrapping around
+	static constexpr float limit = 1 << 28;
+	const float q = std::round(value / step);
+	return q == q ? static_cast<int32_t>(glm::clamp(q, -limit, limit)) : 0;
+}
+
+static void sortByMorton(TrajectoryCodecState& state)
+{
+	for (int i = 0; i < static_cast<int>(PARTICLES_NUMBER); ++i)
+	{
+		const vec2i& q = state.positions[0][i];
+		state.keys[i] = spreadBits(static_cast<uint32_t>(q.x) ^ 0x80000000u) | (spreadBits(static_cast<uint32_t>(q.y) ^ 0x80000000u) << 1);
+		state.order[i] = i;
+	}
+	std::sort(state.order, state.order + PARTICLES_NUMBER, [&](const int& a, const int& b)
+	{
+		return state.keys[a] < state.keys[b] || (state.keys[a] == state.keys[b] && a < b);
+	});
+}
+
+// current becomes the latest frame, the order for the next frame follows it
+// (a keyframe already carries the order of its own positions)
+static void advance(TrajectoryCodecState& state, const bool& keyframe)
+{
+	std::copy(state.positions[0], state.positions[0] + PARTICLES_NUMBER, state.positions[1]);
+	std::copy(state.current, state.current + PARTICLES_NUMBER, state.positions[0]);
+	std::copy(state.currentVelocities, state.currentVelocities + PARTICLES_NUMBER, state.velocities);
+
+	state.history = keyframe ? 1 : Min(state.history + 1, 2);
+	if (!keyframe) sortByMorton(state);
+}
+
+inline vec2i predict(const TrajectoryCodecState& state, const int& i)
+{
+	return state.history >= 2 ? 2 * state.positions[0][i] - state.positions[1][i] : state.positions[0][i];
+}
+
+size_t encodeTrajectoryFrame(TrajectoryCodecState& state, const vec2* positions, const vec2* velocities, const bool& keyframe, unsigned char* out)
+{
+	const bool key = keyframe || state.history == 0;
+
+	for (int i = 0; i < static_cast<int>(PARTICLES_NUMBER); ++i)
+	{
+		const vec2 p = positions[i] - origin;
+		state.current[i] = vec2i(quantise(p.x, trajectoryPositionStep), quantise(p.y, trajectoryPositionStep));
+		state.currentVelocities[i] = vec2i(quantise(velocities[i].x, trajectoryVelocityStep), quantise(velocities[i].y, trajectoryVelocityStep));
+	}
+
+	out[0] = key ? keyframeFlag : 0;
+	out[1] = out[2] = out[3] = 0;
+	BitWriter writer{ out + frameHeaderBytes };
+
+	const int* order = state.order;
+	if (key)
+	{
+		// the keyframe order is taken from the frame itself and has to be sent
+		std::copy(state.current, state.current + PARTICLES_NUMBER, state.positions[0]);
+		sortByMorton(state);
+		for (int k = 0; k < static_cast<int>(PARTICLES_NUMBER); ++k) writer.put(order[k], trajectoryIdBits);
+
+		const vec2i* p = state.current;
+		const vec2i* v = state.currentVelocities;
+		encodeChannel(writer, [&](int k) { return p[order[k]].x - (k ? p[order[k - 1]].x : 0); });
+		encodeChannel(writer, [&](int k) { return p[order[k]].y - (k ? p[order[k - 1]].y : 0); });
+		encodeChannel(writer, [&](int k) { return v[order[k]].x - (k ? v[order[k - 1]].x : 0); });
+		encodeChannel(writer, [&](int k) { return v[order[k]].y - (k ? v[order[k - 1]].y : 0); });
+	}
+	else
+	{
+		encodeChannel(writer, [&](int k) { return state.current[order[k]].x - predict(state, order[k]).x; });
+		encodeChannel(writer, [&](int k) { return state.current[order[k]].y - predict(state, order[k]).y; });
+		encodeChannel(writer, [&](int k) { return state.currentVelocities[order[k]].x - state.velocities[order[k]].x; });
+		encodeChannel(writer, [&](int k) { return state.currentVelocities[order[k]].y - state.velocities[order[k]].y; });
+	}
+	writer.finish();
+
+	advance(state, key);
+	return frameHeaderBytes + writer.bytes;
+}
+
+bool decodeTrajectoryFrame(TrajectoryCodecState& state, const unsigned char* in, const size_t& bytes, vec2* positions, vec2* velocities)
+{
+	if (bytes < frameHeaderBytes || (in[0] & ~keyframeFlag) != 0) return false;
+
+	const bool key = isTrajectoryKeyframe(in);
+	if (!key && state.history == 0) return false;
+
+	BitReader reader{ in + frameHeaderBytes, bytes - frameHeaderBytes };
+
+	if (key)
+	{
+		// a repeated or out of range id would leave a particle undefined
+		std::vector<bool> seen(PARTICLES_NUMBER, false);
+		for (int k = 0; k < static_cast<int>(PARTICLES_NUMBER); ++k)
+		{
+			const uint32_t id = reader.get(trajectoryIdBits);
+			if (id >= PARTICLES_NUMBER || seen[id]) return false;
+			seen[id] = true;
+			state.order[k] = static_cast<int>(id);
+		}
+
+		const int* order = state.order;
+		vec2i* p = state.current;
+		vec2i* v = state.currentVelocities;
+		decodeChannel(reader, [&](int k, int32_t r) { p[order[k]].x = r + (k ? p[order[k - 1]].x : 0); });
+		decodeChannel(reader, [&](int k, int32_t r) { p[order[k]].y = r + (k ? p[order[k - 1]].y : 0); });
+		decodeChannel(reader, [&](int k, int32_t r) { v[order[k]].x = r + (k ? v[order[k - 1]].x : 0); });
+		decodeChannel(reader, [&](int k, int32_t r) { v[order[k]].y = r + (k ? v[order[k - 1]].y : 0); });
+	}
+	else
+	{
+		const int* order = state.order;
+		decodeChannel(reader, [&](int k, int32_t r) { state.current[order[k]].x = r + predict(state, order[k]).x; });
+		decodeChannel(reader, [&](int k, int32_t r) { state.current[order[k]].y = r + predict(state, order[k]).y; });
+		decodeChannel(reader, [&](int k, int32_t r) { state.currentVelocities[order[k]].x = r + state.velocities[order[k]].x; });
+		decodeChannel(reader, [&](int k, int32_t r) { state.currentVelocities[order[k]].y = r + state.velocities[order[k]].y; });
+	}
+	if (reader.overrun()) return false;
+
+	advance(state, key);
+
+	for (int i = 0; i < static_cast<int>(PARTICLES_NUMBER); ++i)
+	{
+		positions[i] = origin + vec2(state.positions[0][i]) * trajectoryPositionStep;
+		velocities[i] = vec2(state.velocities[i]) * trajectoryVelocityStep;
+	}
+	return true;
+}
+
+bool isTrajectoryKeyframe(const unsigned char* in)
+{
+	return (in[0] & keyframeFlag) != 0;
+}
@@ -0,0 +1,54 @@
+#ifndef TRAJECTORY_CODEC
+#define TRAJECTORY_CODEC
+
+#include "../settings.hpp"
+#include <cstdint>
+#include <cstddef>
+#include <bit>
+
+// Lossy trajectory compression. Positions are quantised to
+// trajectoryPositionStep relative to the box corner and velocities to
+// trajectoryVelocityStep, everything after that is lossless.
+//
+// A keyframe lists the particles in Morton order of their positions and
+// stores each value as the difference to the particle before it. Other
+// frames predict every particle from the previous frames (linear
+// extrapolation once two are known) and store the residuals, visited in the
+// Morton order of the previous frame so neighboring residuals sit next to
+// each other. Residuals are zig-zag mapped and Rice coded in blocks of 64
+// with a parameter chosen per block.
+
+static constexpr float    trajectoryPositionStep     = 1.0f / 256.0f;
+static constexpr float    trajectoryVelocityStep     = 1.0f / 1024.0f;
+static constexpr uint32_t trajectoryKeyframeInterval = 32;
+
+static constexpr int    riceBlock          = 64;
+static constexpr int    riceEscape         = 24;
+static constexpr int    trajectoryIdBits   = PARTICLES_NUMBER > 1 ? 32 - std::countl_zero(PARTICLES_NUMBER - 1) : 1;
+// four escaped channels, the keyframe ids and the block parameters
+static constexpr size_t trajectoryMaxEncodedBytes =
+	16 + (4 * PARTICLES_NUMBER * (riceEscape + 32) + PARTICLES_NUMBER * trajectoryIdBits + 4 * 5 * (PARTICLES_NUMBER / riceBlock + 1)) / 8 + 8;
+
+// Encoder and decoder each keep one, they stay in step as long as the decoder
+// sees the same frames from the last keyframe on.
+struct TrajectoryCodecState
+{
+	int history = 0;	// previous frames known, 0 right after a reset
+
+	vec2i positions[2][PARTICLES_NUMBER];	// quantised, [0] is the latest
+	vec2i velocities[PARTICLES_NUMBER];
+	int   order[PARTICLES_NUMBER];			// Morton order of positions[0]
+
+	// the frame being coded and the sort keys
+	vec2i    current[PARTICLES_NUMBER];
+	vec2i    currentVelocities[PARTICLES_NUMBER];
+	uint64_t keys[PARTICLES_NUMBER];
+};
+
+// returns the encoded size, out needs trajectoryMaxEncodedBytes
+size_t encodeTrajectoryFrame(TrajectoryCodecState& state, const vec2* positions, const vec2* velocities, const bool& keyframe, unsigned char* out);
+// fails on a delta frame without its keyframe or on malformed input
+bool decodeTrajectoryFrame(TrajectoryCodecState& state, const unsigned char* in, const size_t& bytes, vec2* positions, vec2* velocities);
+bool isTrajectoryKeyframe(const unsigned char* in);
+
+#endif
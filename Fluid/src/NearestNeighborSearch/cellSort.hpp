@@ -0,0 +1,35 @@
+#ifndef CELL_SORT
+#define CELL_SORT
+
+#include "../settings.hpp"
+#include <algorithm>
+
+// Orders sorted[begin, end) by x and writes the keys to sortedX. Every
+// rebuild scatters the particles in index order, so nothing of the previous
+// order is kept and the insertion sort is quadratic in the cell size; cells
+// hold a handful of particles, where it still beats a general sort.
+inline void sortCellByX(int* sorted, float* sortedX, const vec2* positions, const unsigned& begin, const unsigned& end)
+{
+	for (unsigned s = begin; s < end; ++s)
+	{
+		const int index = sorted[s];
+		const float x = positions[index].x;
+
+		unsigned t = s;
+		for (; t > begin && sortedX[t - 1] > x; --t)
+		{
+			sorted[t] = sorted[t - 1];
+			sortedX[t] = sortedX[t - 1];
+		}
+		sorted[t] = index;
+		sortedX[t] = x;
+	}
+}
+
+// first slot of the x-sorted run [begin, end) that can lie within influenceRadius of x
+inline unsigned firstWithinX(const float* sortedX, const unsigned& begin, const unsigned& end, const float& x)
+{
+	return static_cast<unsigned>(std::lower_bound(sortedX + begin, sortedX + end, x - influenceRadius) - sortedX);
+}
+
+#endif
@@ -0,0 +1,105 @@
+#include "compactGrid.hpp"
+#include <algorithm>
+#include <chrono>
+
+CompactGrid compactGrid;
+
+static unsigned cursor[compactCellsMax];
+
+void setCompactGridDivisions(const int& k)
+{
+	compactGrid.divisions = k;
+	compactGrid.stride = cells_x * k + 2 * k;
+	compactGrid.runs = 2 * k + 1;
+
+	for (int dy = -k; dy <= k; ++dy)
+	{
+		// widest dx whose cell still has a point within k cells of the query cell
+		const int gy = Max(glm::abs(dy) - 1, 0);
+		int width = 0;
+		while (width < k && width * width + gy * gy < k * k) width++;
+
+		compactGrid.runStart[dy + k] = dy * compactGrid.stride - width;
+		compactGrid.runLength[dy + k] = 2 * width + 1;
+	}
+}
+
+void rebuildCompactGrid(const vec2* positions, const int& count)
+{
+	#pragma omp for schedule(static)
+	for (int i = 0; i < count; ++i)
+	{
+		compactGrid.cells[i] = GetCompactCell(positions[i]);
+	}
+
+	#pragma omp single
+	{
+		const unsigned cellsUsed = compactGrid.stride * (cells_y * compactGrid.divisions + 2 * compactGrid.divisions);
+		std::fill(compactGrid.cellStart, compactGrid.cellStart + cellsUsed + 1, 0U);
+
+		for (int i = 0; i < count; ++i)
+		{
+			compactGrid.cellStart[compactGrid.cells[i] + 1]++;
+		}
+		for (unsigned c = 0; c < cellsUsed; ++c)
+		{
+			compactGrid.cellStart[c + 1] += compactGrid.cellStart[c];
+		}
+
+		std::copy(compactGrid.cellStart, compactGrid.cellStart + cellsUsed, cursor);
+		for (int i = 0; i < count; ++i)
+		{
+			compactGrid.sorted[cursor[compactGrid.cells[i]]++] = i;
+		}
+	}
+
+	const int cellsUsed = compactGrid.stride * (cells_y * compactGrid.divisions + 2 * compactGrid.divisions);
+
+	#pragma omp for schedule(dynamic, 64)
+	for (int c = 0; c < cellsUsed; ++c)
+	{
+		sortCellByX(compactGrid.sorted, compactGrid.sortedX, positions, compactGrid.cellStart[c], compactGrid.cellStart[c + 1]);
+	}
+}
+
+int tuneCompactGrid(const vec2* positions, const int& count)
+{
+	using Clock = std::chrono::steady_clock;
+
+	int best = 1;
+	double bestTime = 0.0;
+	double bestRatio = 0.0;
+
+	for (int k = 1; k <= maxCellDivisions; ++k)
+	{
+		setCompactGridDivisions(k);
+
+		const auto start = Clock::now();
+		rebuildCompactGrid(positions, count);
+
+		long long candidates = 0;
+		long long neighbors = 0;
+		for (int i = 0; i < count; ++i)
+		{
+			forEachCompactNeighbor(i, positions[i], [&](const int& j)
+			{
+				candidates++;
+				neighbors += length2(positions[i] - positions[j]) < influenceRadius * influenceRadius;
+			});
+		}
+		const double time = std::chrono::duration<double>(Clock::now() - start).count();
+
+		if (k == 1 || time < bestTime)
+		{
+			best = k;
+			bestTime = time;
+			bestRatio = neighbors ? static_cast<double>(candidates) / neighbors : 0.0;
+		}
+	}
+
+	setCompactGridDivisions(best);
+	rebuildCompactGrid(positions, count);
+
+	compactGrid.candidateRatio = static_cast<float>(bestRatio);
+	return best;
+}
@@ -0,0 +1,85 @@
+#ifndef COMPACT_GRID
+#define COMPACT_GRID
+
+#include "segments.hpp"
+#include "cellSort.hpp"
+
+// Counting-sorted grid over the box. The particles of a cell are stored
+// contiguously in cell order, so every row of the stencil is one contiguous
+// run of the sorted array.
+//
+// The cell edge is area / k. A query then walks a (2k+1)^2 stencil pruned
+// to the cells that can hold a point within influenceRadius, which cuts the
+// candidates scanned outside the radius. The ghost ring is k cells wide, so the
+// runs never leave the array. tuneCompactGrid times every k on the current
+// particles and keeps the fastest one; it prints nothing, the driver reports
+// divisions and candidateRatio if it wants to.
+//
+// Inside a cell the particles are ordered by x. The cells of a run are
+// consecutive in x too, so a whole run is x-sorted. A query binary-searches
+// to pos.x - influenceRadius and stops at the first candidate past
+// pos.x + influenceRadius.
+
+static constexpr int maxCellDivisions = 4;
+
+static constexpr unsigned compactStrideMax = cells_x * maxCellDivisions + 2 * maxCellDivisions;
+static constexpr unsigned compactRowsMax   = cells_y * maxCellDivisions + 2 * maxCellDivisions;
+static constexpr unsigned compactCellsMax  = compactStrideMax * compactRowsMax;
+
+struct CompactGrid
+{
+	int divisions = 1;
+	int stride = cells_x + 2;
+
+	// stencil rows: first cell relative to the query cell and number of cells
+	int runs = 3;
+	int runStart[2 * maxCellDivisions + 1] = { -stride - 1, -1, stride - 1 };
+	int runLength[2 * maxCellDivisions + 1] = { 3, 3, 3 };
+
+	// candidates scanned per neighbor found at the last tuning
+	float candidateRatio = 0.0f;
+
+	unsigned cellStart[compactCellsMax + 1] = { 0 };
+	int      sorted[PARTICLES_NUMBER];
+	float    sortedX[PARTICLES_NUMBER];
+	int      cells[PARTICLES_NUMBER];
+};
+
+extern CompactGrid compactGrid;
+
+inline int GetCompactCell(const vec2& pos)
+{
+	const int k = compactGrid.divisions;
+	const float inverse = k * scale / area;
+
+	const int x = glm::clamp(static_cast<int>(glm::floor((pos.x - BOXMARGINX) * inverse)), 0, static_cast<int>(cells_x) * k - 1);
+	const int y = glm::clamp(static_cast<int>(glm::floor((pos.y - BOXMARGINY) * inverse)), 0, static_cast<int>(cells_y) * k - 1);
+
+	return (y + k) * compactGrid.stride + (x + k);
+}
+
+void setCompactGridDivisions(const int& k);
+void rebuildCompactGrid(const vec2* positions, const int& count = PARTICLES_NUMBER);
+int  tuneCompactGrid(const vec2* positions, const int& count = PARTICLES_NUMBER);
+
+template <typename Func>
+inline void forEachCompactNeighbor(const int& Index, const vec2& pos, Func&& func)
+{
+	const int cell = Index >= 0 ? compactGrid.cells[Index] : GetCompactCell(pos);
+
+	for (int r = 0; r < compactGrid.runs; ++r)
+	{
+		const int first = cell + compactGrid.runStart[r];
+		const unsigned end = compactGrid.cellStart[first + compactGrid.runLength[r]];
+
+		unsigned s = firstWithinX(compactGrid.sortedX, compactGrid.cellStart[first], end, pos.x);
+		for (; s < end && compactGrid.sortedX[s] <= pos.x + influenceRadius; ++s)
+		{
+			const int j = compactGrid.sorted[s];
+			if (j == Index) continue;
+			func(j);
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,42 @@
+#include "hashGrid.hpp"
+#include <algorithm>
+
+HashGrid hashGrid;
+
+static unsigned cursor[hashTableSize];
+
+void rebuildHashGrid(const vec2* positions, const int& count)
+{
+	#pragma omp for schedule(static)
+	for (int i = 0; i < count; ++i)
+	{
+		hashGrid.cells[i] = GetCellCoords(positions[i]);
+		hashGrid.hashes[i] = HashCell(hashGrid.cells[i]);
+	}
+
+	#pragma omp single
+	{
+		std::fill(hashGrid.cellStart, hashGrid.cellStart + hashTableSize + 1, 0U);
+
+		for (int i = 0; i < count; ++i)
+		{
+			hashGrid.cellStart[hashGrid.hashes[i] + 1]++;
+		}
+		for (unsigned h = 0; h < hashTableSize; ++h)
+		{
+			hashGrid.cellStart[h + 1] += hashGrid.cellStart[h];
+		}
+
+		std::copy(hashGrid.cellStart, hashGrid.cellStart + hashTableSize, cursor);
+		for (int i = 0; i < count; ++i)
+		{
+			hashGrid.sorted[cursor[hashGrid.hashes[i]]++] = i;
+		}
+	}
+
+	#pragma omp for schedule(dynamic, 64)
+	for (int h = 0; h < static_cast<int>(hashTableSize); ++h)
+	{
+		sortCellByX(hashGrid.sorted, hashGrid.sortedX, positions, hashGrid.cellStart[h], hashGrid.cellStart[h + 1]);
+	}
+}
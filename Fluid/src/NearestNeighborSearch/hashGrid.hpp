@@ -0,0 +1,80 @@
+#ifndef HASH_GRID
+#define HASH_GRID
+
+#include "cellSort.hpp"
+
+// Spatial hash over integer cell coordinates. Cells are not bounded by the BOX,
+// a particle anywhere in the plane lands in one of hashTableSize buckets, and
+// the buckets are filled by a counting sort so memory only grows with the
+// particle count. Colliding cells share a bucket and are told apart by the
+// stored cell coordinates. Buckets are ordered by x, so a query skips to
+// pos.x - influenceRadius and stops past pos.x + influenceRadius.
+
+inline constexpr unsigned staticPowerOf2(unsigned n)
+{
+	unsigned p = 1;
+	while (p < n) p <<= 1;
+	return p;
+}
+
+static constexpr unsigned hashTableSize = staticPowerOf2(2 * PARTICLES_NUMBER);
+
+struct HashGrid
+{
+	unsigned cellStart[hashTableSize + 1] = { 0 };
+	int      sorted[PARTICLES_NUMBER];
+	float    sortedX[PARTICLES_NUMBER];
+	unsigned hashes[PARTICLES_NUMBER];
+	vec2i    cells[PARTICLES_NUMBER];
+};
+
+extern HashGrid hashGrid;
+
+inline vec2i GetCellCoords(const vec2& pos)
+{
+	return vec2i(glm::floor(pos * scale / area));
+}
+inline unsigned HashCell(const vec2i& cell)
+{
+	return ((static_cast<unsigned>(cell.x) * 73856093u) ^ (static_cast<unsigned>(cell.y) * 19349663u))
+		& (hashTableSize - 1);
+}
+
+void rebuildHashGrid(const vec2* positions, const int& count = PARTICLES_NUMBER);
+
+template <typename Func>
+inline void forEachHashNeighbor(const int& Index, const vec2& pos, Func&& func)
+{
+	const vec2i cell = Index >= 0 ? hashGrid.cells[Index] : GetCellCoords(pos);
+
+	unsigned visited[9];
+	int count = 0;
+
+	for (int dy = -1; dy <= 1; ++dy)
+	{
+		for (int dx = -1; dx <= 1; ++dx)
+		{
+			const unsigned bucket = HashCell(cell + vec2i(dx, dy));
+
+			// two cells of the stencil may hash to the same bucket
+			bool seen = false;
+			for (int k = 0; k < count; ++k) seen |= visited[k] == bucket;
+			if (seen) continue;
+			visited[count++] = bucket;
+
+			const unsigned end = hashGrid.cellStart[bucket + 1];
+
+			unsigned s = firstWithinX(hashGrid.sortedX, hashGrid.cellStart[bucket], end, pos.x);
+			for (; s < end && hashGrid.sortedX[s] <= pos.x + influenceRadius; ++s)
+			{
+				const int j = hashGrid.sorted[s];
+				const vec2i d = hashGrid.cells[j] - cell;
+
+				if (j == Index || d.x < -1 || d.x > 1 || d.y < -1 || d.y > 1) continue;
+				func(j);
+			}
+		}
+	}
+}
+
+#endif
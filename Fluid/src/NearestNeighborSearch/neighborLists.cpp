@@ -0,0 +1,31 @@
+#include "neighborLists.hpp"
+
+NeighborLists neighborLists;
+
+void buildNeighborLists(const vec2* positions, const int& count)
+{
+	#pragma omp single
+	neighborLists.overflows = 0;
+
+	#pragma omp for schedule(dynamic, 16)
+	for (int i = 0; i < count; ++i)
+	{
+		int n = 0;
+		int dropped = 0;
+
+		forEachNeighbor(i, positions[i], [&](const int& j)
+		{
+			if (length2(positions[i] - positions[j]) >= influenceRadius * influenceRadius) return;
+
+			if (n < maxNeighbors) neighborLists.indices[i][n++] = j;
+			else dropped++;
+		});
+		neighborLists.counts[i] = n;
+
+		if (dropped)
+		{
+			#pragma omp atomic
+			neighborLists.overflows += dropped;
+		}
+	}
+}
@@ -0,0 +1,34 @@
+#ifndef NEIGHBOR_LISTS
+#define NEIGHBOR_LISTS
+
+#include "neighbors.hpp"
+
+// Explicit per-particle lists of the neighbors closer than influenceRadius,
+// gathered once from the selected backend so later passes walk a flat array.
+// Each particle has a fixed slot of maxNeighbors entries; neighbors past that
+// are dropped and counted in overflows.
+
+static constexpr int maxNeighbors = 128;
+
+struct NeighborLists
+{
+	int counts[PARTICLES_NUMBER];
+	int indices[PARTICLES_NUMBER][maxNeighbors];
+	int overflows = 0;
+};
+
+extern NeighborLists neighborLists;
+
+void buildNeighborLists(const vec2* positions, const int& count = PARTICLES_NUMBER);
+
+template <typename Func>
+inline void forEachListedNeighbor(const int& Index, Func&& func)
+{
+	const int* list = neighborLists.indices[Index];
+	for (int k = 0; k < neighborLists.counts[Index]; ++k)
+	{
+		func(list[k]);
+	}
+}
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef NEIGHBORS
+#define NEIGHBORS
+
+#include "segments.hpp"
+#include "compactGrid.hpp"
+#include "hashGrid.hpp"
+#include "quadtree.hpp"
+
+// Visits the neighbor candidates j != Index of pos with the backend selected by
+// neighborSearch: the 3x3 cell block for the grids, every j closer than
+// max(h_i, h_j) for the quadtree. For a particle (Index >= 0) the cell cached
+// by the backend is used, pos then has to be the position the grid was built
+// from.
+//
+// refreshNeighborSearch runs after each pass that moves the predicted
+// positions: the segments grid applies the cell changes newUpdateSegment
+// recorded, the other backends are rebuilt.
+template <typename Func>
+inline void forEachNeighbor(const int& Index, const vec2& pos, Func&& func)
+{
+	if constexpr (neighborSearch == NeighborSearch::CompactGrid)
+	{
+		forEachCompactNeighbor(Index, pos, func);
+	}
+	else if constexpr (neighborSearch == NeighborSearch::HashGrid)
+	{
+		forEachHashNeighbor(Index, pos, func);
+	}
+	else if constexpr (neighborSearch == NeighborSearch::Quadtree)
+	{
+		forEachQuadtreeNeighbor(Index, pos, func);
+	}
+	else
+	{
+		const unsigned segInd = Index >= 0 ? segmentIndices[Index] : GetSegmentIndex(pos);
+
+		for (int locShift = 0; locShift < 9; locShift++)
+		{
+			const int location = GetLocationFromShift(segInd, locShift);
+
+			for (Node* seg = segments.segments[location]; seg; seg = seg->next)
+			{
+				if (seg->value == Index) continue;
+				func(seg->value);
+			}
+		}
+	}
+}
+
+inline void refreshNeighborSearch(const vec2* positions, const int& count = PARTICLES_NUMBER)
+{
+	if constexpr (neighborSearch == NeighborSearch::CompactGrid) rebuildCompactGrid(positions, count);
+	else if constexpr (neighborSearch == NeighborSearch::HashGrid) rebuildHashGrid(positions, count);
+	else if constexpr (neighborSearch == NeighborSearch::Quadtree) rebuildQuadtree(positions, count);
+	else applySegmentMoves();
+}
+
+// called once per frame outside the solvers' parallel regions
+inline void maintainNeighborSearch(const vec2* positions)
+{
+	if constexpr (neighborSearch == NeighborSearch::CompactGrid)
+	{
+		static int frame = 0;
+		if (frame++ % gridTuningInterval == 0) tuneCompactGrid(positions);
+	}
+}
+
+#endif
@@ -0,0 +1,90 @@
+#include "quadtree.hpp"
+#include <algorithm>
+#include <bit>
+
+Quadtree quadtree;
+alignas(64) float smoothingLengths[PARTICLES_NUMBER];
+
+// number of 2-bit levels above which the keys of the range agree
+static int commonLevel(const uint64_t& a, const uint64_t& b)
+{
+	const uint64_t diff = a ^ b;
+	return diff ? (63 - std::countl_zero(diff)) / 2 + 1 : 0;
+}
+
+static float buildNode(const int& index, const int& first, const int& last)
+{
+	QuadNode& node = quadtree.nodes[index];
+	const uint64_t* keys = quadtree.sortedKeys;
+
+	const int level = commonLevel(keys[first], keys[last - 1]);
+	const uint64_t prefix = level < 32 ? keys[first] >> (2 * level) : 0;
+
+	node.min = GetMortonCorner(level < 32 ? prefix << (2 * level) : 0);
+	node.size = quadtreeQuantum * static_cast<float>(uint64_t(1) << level);
+	node.first = first;
+	node.last = last;
+	node.child = 0;
+	node.children = 0;
+	node.maxH = 0.0f;
+
+	// ranges of one quantum cell cannot be split further
+	if (last - first <= quadtreeLeafSize || level == 0)
+	{
+		for (int s = first; s < last; ++s)
+		{
+			node.maxH = Max(node.maxH, smoothingLengths[quadtree.sorted[s]]);
+		}
+		return node.maxH;
+	}
+
+	// split the range by the 2 key bits of the level below
+	int bounds[5] = { first, 0, 0, 0, last };
+	for (int c = 1; c < 4; ++c)
+	{
+		const uint64_t start = ((prefix << 2) | c) << (2 * (level - 1));
+		bounds[c] = static_cast<int>(std::lower_bound(keys + first, keys + last, start) - keys);
+	}
+
+	node.child = quadtree.nodeCount;
+	for (int c = 0; c < 4; ++c)
+	{
+		if (bounds[c] < bounds[c + 1]) node.children++;
+	}
+	quadtree.nodeCount += node.children;
+
+	int child = node.child;
+	float maxH = 0.0f;
+	for (int c = 0; c < 4; ++c)
+	{
+		if (bounds[c] == bounds[c + 1]) continue;
+		maxH = Max(maxH, buildNode(child++, bounds[c], bounds[c + 1]));
+	}
+	node.maxH = maxH;
+	return maxH;
+}
+
+void rebuildQuadtree(const vec2* positions, const int& count)
+{
+	#pragma omp for schedule(static)
+	for (int i = 0; i < count; ++i)
+	{
+		quadtree.keys[i] = GetMortonKey(positions[i]);
+		quadtree.sorted[i] = i;
+	}
+
+	#pragma omp single
+	{
+		std::sort(quadtree.sorted, quadtree.sorted + count, [](const int& a, const int& b) {
+			return quadtree.keys[a] < quadtree.keys[b];
+		});
+		for (int s = 0; s < count; ++s)
+		{
+			quadtree.sortedKeys[s] = quadtree.keys[quadtree.sorted[s]];
+		}
+
+		quadtree.positions = positions;
+		quadtree.nodeCount = count > 0 ? 1 : 0;
+		if (count > 0) buildNode(0, 0, count);
+	}
+}
@@ -0,0 +1,115 @@
+#ifndef QUADTREE
+#define QUADTREE
+
+#include "../settings.hpp"
+#include <cstdint>
+
+// Linear quadtree over Morton keys. Positions are quantised to quadtreeQuantum
+// on an unbounded 2^32 x 2^32 lattice, sorted by key, and every node is a
+// contiguous key range. Chains of single-child levels are collapsed, so a node
+// always splits into 2..4 children and the tree holds fewer than 2N nodes.
+// Each node keeps the largest smoothing length below it, which lets a query
+// find every j with |x_i - x_j| < max(h_i, h_j) for per-particle h.
+
+static constexpr float quadtreeQuantum  = radius / 16.0f;
+static constexpr int   quadtreeLeafSize = 8;
+static constexpr int   quadtreeMaxNodes = 2 * PARTICLES_NUMBER;
+
+struct QuadNode
+{
+	vec2  min;
+	float size;
+	float maxH;
+	int   first, last;		// range in sorted
+	int   child, children;	// children are stored contiguously, 0 for leaves
+};
+
+struct Quadtree
+{
+	uint64_t keys[PARTICLES_NUMBER];
+	uint64_t sortedKeys[PARTICLES_NUMBER];
+	int      sorted[PARTICLES_NUMBER];
+	QuadNode nodes[quadtreeMaxNodes];
+	int      nodeCount = 0;
+
+	const vec2* positions = nullptr;	// positions the tree was built from
+};
+
+extern Quadtree quadtree;
+extern alignas(64) float smoothingLengths[PARTICLES_NUMBER];
+
+inline uint64_t spreadBits(uint64_t v)
+{
+	v = (v | (v << 16)) & 0x0000FFFF0000FFFFull;
+	v = (v | (v << 8))  & 0x00FF00FF00FF00FFull;
+	v = (v | (v << 4))  & 0x0F0F0F0F0F0F0F0Full;
+	v = (v | (v << 2))  & 0x3333333333333333ull;
+	v = (v | (v << 1))  & 0x5555555555555555ull;
+	return v;
+}
+inline uint32_t compactBits(uint64_t v)
+{
+	v &= 0x5555555555555555ull;
+	v = (v | (v >> 1))  & 0x3333333333333333ull;
+	v = (v | (v >> 2))  & 0x0F0F0F0F0F0F0F0Full;
+	v = (v | (v >> 4))  & 0x00FF00FF00FF00FFull;
+	v = (v | (v >> 8))  & 0x0000FFFF0000FFFFull;
+	v = (v | (v >> 16)) & 0x00000000FFFFFFFFull;
+	return static_cast<uint32_t>(v);
+}
+
+inline uint64_t GetMortonKey(const vec2& pos)
+{
+	// the lattice is centred on the origin
+	const auto quantise = [](float c) {
+		return static_cast<uint32_t>(static_cast<int64_t>(glm::floor(c / quadtreeQuantum)) + (int64_t(1) << 31));
+	};
+	return spreadBits(quantise(pos.x)) | (spreadBits(quantise(pos.y)) << 1);
+}
+inline vec2 GetMortonCorner(const uint64_t& key)
+{
+	const auto position = [](uint32_t q) {
+		return static_cast<float>(static_cast<int64_t>(q) - (int64_t(1) << 31)) * quadtreeQuantum;
+	};
+	return vec2(position(compactBits(key)), position(compactBits(key >> 1)));
+}
+
+void rebuildQuadtree(const vec2* positions, const int& count = PARTICLES_NUMBER);
+
+template <typename Func>
+inline void forEachQuadtreeNeighbor(const int& Index, const vec2& pos, Func&& func)
+{
+	const float h = Index >= 0 ? smoothingLengths[Index] : influenceRadius;
+
+	// a compressed tree over 64-bit keys is at most 33 levels deep, each level leaves 3 siblings
+	int stack[3 * 33 + 1];
+	int top = 0;
+	if (quadtree.nodeCount > 0) stack[top++] = 0;
+
+	while (top > 0)
+	{
+		const QuadNode& node = quadtree.nodes[stack[--top]];
+		const float reach = Max(h, node.maxH);
+
+		const vec2 nearest = glm::clamp(pos, node.min, node.min + vec2(node.size));
+		if (length2(pos - nearest) >= reach * reach) continue;
+
+		if (node.children > 0)
+		{
+			for (int c = 0; c < node.children; ++c) stack[top++] = node.child + c;
+			continue;
+		}
+
+		for (int s = node.first; s < node.last; ++s)
+		{
+			const int j = quadtree.sorted[s];
+			if (j == Index) continue;
+
+			const float r = Max(h, smoothingLengths[j]);
+			if (length2(pos - quadtree.positions[j]) >= r * r) continue;
+			func(j);
+		}
+	}
+}
+
+#endif
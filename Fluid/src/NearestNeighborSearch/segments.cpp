@@ -1,14 +1,144 @@
 #include "segments.hpp"
+#include <omp.h>
+#include <algorithm>
+
+alignas(64) List segments;
+alignas(64) int  segmentIndices[PARTICLES_NUMBER];
+
+// one buffer per thread, the count leads each buffer so threads never share a cache line
+struct alignas(64) MoveBuffer
+{
+	int count = 0;
+	SegmentMove moves[PARTICLES_NUMBER];
+};
+static MoveBuffer moveBuffers[threads];
+
+// moves bucketed by the cell they leave and the cell they enter,
+// a particle changes cell at most once per pass
+alignas(64) static unsigned leaveCount[cellsSize];
+alignas(64) static unsigned enterCount[cellsSize];
+alignas(64) static unsigned leaveStart[cellsSize + 1];
+alignas(64) static unsigned enterStart[cellsSize + 1];
+alignas(64) static int leaving[PARTICLES_NUMBER];
+alignas(64) static int entering[PARTICLES_NUMBER];
 
 int GetSegmentIndex(const vec2& pos)
 {
 	int x = glm::floor((pos.x - BOXMARGINX) * scale / area);
 	int y = glm::floor((pos.y - BOXMARGINY) * scale / area);
 
-	return y * cells_x + x;
+	// positions pushed past the walls are binned into the border cells, the ghost ring stays empty
+	x = glm::clamp(x, 0, static_cast<int>(cells_x) - 1);
+	y = glm::clamp(y, 0, static_cast<int>(cells_y) - 1);
+
+	return (y + 1) * gridStride + (x + 1);
+}
+
+void buildSegments(const vec2* positions, const int& count)
+{
+	std::fill(segments.segments, segments.segments + cellsSize, nullptr);
+
+	for (int i = 0; i < count; ++i)
+	{
+		const int unit = GetSegmentIndex(positions[i]);
+		Node* node = segments.indices + i;
+
+		segmentIndices[i] = unit;
+		node->value = i;
+		node->prev = nullptr;
+		node->next = segments.segments[unit];
+
+		if (segments.segments[unit]) segments.segments[unit]->prev = node;
+		segments.segments[unit] = node;
+	}
 }
-int GetLocationFromShift(const unsigned& loc, const unsigned& shift)
+
+void recordSegmentMove(const int& i, const int& pre, const int& post)
 {
-	int ret = loc + (cells_x * (shift / 3 - 1)) - 1 + shift % 3;
-	return (ret >= cellsSize) ? -1 : ret;
-}
\ No newline at end of file
+	MoveBuffer& buffer = moveBuffers[omp_get_thread_num()];
+	buffer.moves[buffer.count++] = { i, pre, post };
+}
+
+// Called by every thread of the team after the pass that recorded the moves
+// (or serially outside a parallel region). Unlinking only touches nodes of the
+// cell being left and linking only the head of the cell being entered, so one
+// thread per cell needs no locks; the barrier between the two phases keeps a
+// list from being unlinked and linked at the same time.
+void applySegmentMoves()
+{
+	int total = 0;
+	for (int t = 0; t < threads; ++t) total += moveBuffers[t].count;
+	if (total == 0) return;
+
+	// bucketing is linear in the moves and cells, one thread does it faster
+	// than the extra barriers a parallel count and fill would cost
+	#pragma omp single
+	{
+		std::fill(leaveCount, leaveCount + cellsSize, 0U);
+		std::fill(enterCount, enterCount + cellsSize, 0U);
+
+		for (int t = 0; t < threads; ++t)
+		{
+			for (int k = 0; k < moveBuffers[t].count; ++k)
+			{
+				leaveCount[moveBuffers[t].moves[k].pre]++;
+				enterCount[moveBuffers[t].moves[k].post]++;
+			}
+		}
+
+		leaveStart[0] = 0;
+		enterStart[0] = 0;
+		for (unsigned c = 0; c < cellsSize; ++c)
+		{
+			leaveStart[c + 1] = leaveStart[c] + leaveCount[c];
+			enterStart[c + 1] = enterStart[c] + enterCount[c];
+		}
+
+		// the counts are reused as fill cursors
+		for (int t = 0; t < threads; ++t)
+		{
+			for (int k = 0; k < moveBuffers[t].count; ++k)
+			{
+				const SegmentMove& move = moveBuffers[t].moves[k];
+
+				leaving[leaveStart[move.pre] + --leaveCount[move.pre]] = move.index;
+				entering[enterStart[move.post] + --enterCount[move.post]] = move.index;
+			}
+		}
+	}
+
+	#pragma omp for schedule(dynamic, 8)
+	for (int c = 0; c < static_cast<int>(cellsSize); ++c)
+	{
+		for (unsigned k = leaveStart[c]; k < leaveStart[c + 1]; ++k)
+		{
+			Node& node = segments.indices[leaving[k]];
+
+			if (node.next) node.next->prev = node.prev;
+			if (node.prev) node.prev->next = node.next;
+			else segments.segments[c] = node.next;
+		}
+	}
+
+	// every thread has read the counts by now, they are cleared before the barrier of the link pass
+	#pragma omp for schedule(static) nowait
+	for (int t = 0; t < threads; ++t)
+	{
+		moveBuffers[t].count = 0;
+	}
+
+	#pragma omp for schedule(dynamic, 8)
+	for (int c = 0; c < static_cast<int>(cellsSize); ++c)
+	{
+		for (unsigned k = enterStart[c]; k < enterStart[c + 1]; ++k)
+		{
+			Node* node = segments.indices + entering[k];
+
+			node->next = segments.segments[c];
+			node->prev = nullptr;
+
+			if (segments.segments[c]) segments.segments[c]->prev = node;
+			segments.segments[c] = node;
+		}
+	}
+}
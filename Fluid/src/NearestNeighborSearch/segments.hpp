@@ -14,7 +14,24 @@ using node_t = int;
 static constexpr unsigned cells_x = staticCeil(BOXWIDTH * 1.0f / area);
 static constexpr unsigned cells_y = staticCeil(BOXHEIGHT * 1.0f / area);
 
-static constexpr unsigned cellsSize = cells_x * cells_y;
+// the cells are stored with a ring of empty ghost cells around the box, so
+// every interior cell has all 8 neighbors in memory and the stencil needs
+// neither bounds checks nor row arithmetic
+static constexpr unsigned gridStride = cells_x + 2;
+static constexpr unsigned gridRows   = cells_y + 2;
+
+static constexpr unsigned cellsSize = gridStride * gridRows;
+
+static constexpr int stride = static_cast<int>(gridStride);
+
+// row-major 3x3 stencil, entry 4 is the cell itself
+static constexpr int stencilOffsets[9] = {
+	-stride - 1, -stride, -stride + 1,
+	-1,          0,       1,
+	 stride - 1,  stride,  stride + 1,
+};
+// forward half of the stencil, each unordered cell pair appears once
+static constexpr int forwardOffsets[4] = { 1, stride - 1, stride, stride + 1 };
 
 struct Node
 {
@@ -28,7 +45,30 @@ struct List
 	Node* segments[cellsSize] = { 0 };
 };
 
+extern List segments;
+
+// cell each particle is linked into, kept in step with the lists so passes and
+// queries never recompute it for positions that did not move
+extern alignas(64) int segmentIndices[PARTICLES_NUMBER];
+
+// Cell changes are recorded per thread while a pass runs and applied together
+// by applySegmentMoves, bucketed by cell so every list is edited by one thread.
+struct SegmentMove
+{
+	int index;
+	int pre;
+	int post;
+};
+
+void recordSegmentMove(const int& i, const int& pre, const int& post);
+void applySegmentMoves();
+
 int GetSegmentIndex(const vec2& pos);
-int GetLocationFromShift(const unsigned& loc, const unsigned& shift);
+void buildSegments(const vec2* positions, const int& count = PARTICLES_NUMBER);
+
+inline int GetLocationFromShift(const unsigned& loc, const unsigned& shift)
+{
+	return static_cast<int>(loc) + stencilOffsets[shift];
+}
 
 #endif
\ No newline at end of file
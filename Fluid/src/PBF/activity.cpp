@@ -0,0 +1,117 @@
+#include "activity.hpp"
+
+static constexpr float sleep_velocity       = 0.005f;
+static constexpr float wake_velocity        = 0.02f;
+static constexpr float sleep_density_change = 0.001f;
+static constexpr int   sleep_steps          = 30;
+
+alignas(64) int activeIndices[PARTICLES_NUMBER];
+int activeCount = 0;
+
+alignas(64) static float previousErrors[PARTICLES_NUMBER];
+alignas(64) static int   calmSteps[PARTICLES_NUMBER];
+
+alignas(64) static bool asleep[PARTICLES_NUMBER];
+alignas(64) static bool asleepNext[PARTICLES_NUMBER];
+alignas(64) static bool cellAwake[cellsSize];
+
+void updateActivity()
+{
+	if constexpr (!sleepingParticles)
+	{
+		if (activeCount != PARTICLES_NUMBER) wakeAll();
+		return;
+	}
+
+	// cells holding at least one awake particle, sleepers elsewhere skip the neighbor test
+	if constexpr (neighborSearch == NeighborSearch::Segments)
+	{
+		std::fill(cellAwake, cellAwake + cellsSize, false);
+		for (int i = 0; i < PARTICLES_NUMBER; ++i)
+		{
+			if (!asleep[i]) cellAwake[segmentIndices[i]] = true;
+		}
+	}
+
+	#pragma omp parallel for schedule(static) num_threads(scene.threads)
+	for (int i = 0; i < PARTICLES_NUMBER; ++i)
+	{
+		if (asleep[i])
+		{
+			asleepNext[i] = !isDisturbed(i);
+			continue;
+		}
+
+		// the constraint of a resting particle settles to a constant, not to zero
+		const float change = glm::abs(densityErrors[i] - previousErrors[i]);
+		const bool calm = glm::length(particles.dir[i]) < sleep_velocity
+			&& change <= sleep_density_change * Max(glm::abs(densityErrors[i]), 1.0f);
+
+		previousErrors[i] = densityErrors[i];
+		calmSteps[i] = calm ? calmSteps[i] + 1 : 0;
+		asleepNext[i] = calmSteps[i] >= sleep_steps;
+	}
+
+	activeCount = 0;
+	for (int i = 0; i < PARTICLES_NUMBER; ++i)
+	{
+		if (asleepNext[i] && !asleep[i])
+		{
+			particles.dir[i] = { 0.0, 0.0 };
+			external[i] = { 0.0, 0.0 };
+		}
+		else if (!asleepNext[i] && asleep[i])
+		{
+			calmSteps[i] = 0;
+		}
+		asleep[i] = asleepNext[i];
+
+		if (!asleep[i]) activeIndices[activeCount++] = i;
+	}
+}
+void wakeAll()
+{
+	for (int i = 0; i < PARTICLES_NUMBER; ++i)
+	{
+		asleep[i] = false;
+		calmSteps[i] = 0;
+		activeIndices[i] = i;
+	}
+	activeCount = PARTICLES_NUMBER;
+}
+bool isAsleep(const int& Index)
+{
+	return asleep[Index];
+}
+bool isDisturbed(const int& Index)
+{
+	const vec2& pos = particles.centers[Index];
+
+	if (interactionInputStrength != 0.0)
+	{
+		const float reach = interactionInputRadius + influenceRadius;
+		if (length2(interactionInputPoint - pos) < reach * reach) return true;
+	}
+
+	if constexpr (neighborSearch == NeighborSearch::Segments)
+	{
+		const unsigned segInd = segmentIndices[Index];
+		bool quiet = true;
+
+		for (int locShift = 0; locShift < 9; locShift++)
+		{
+			if (cellAwake[GetLocationFromShift(segInd, locShift)]) quiet = false;
+		}
+		if (quiet) return false;
+	}
+
+	bool disturbed = false;
+	forEachNeighbor(Index, pos, [&](const int& j)
+	{
+		if (asleep[j]) return;
+
+		disturbed |= length2(pos - particles.centers[j]) < influenceRadius * influenceRadius
+			&& glm::length(particles.dir[j]) > wake_velocity;
+	});
+	return disturbed;
+}
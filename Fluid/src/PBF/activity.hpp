@@ -0,0 +1,18 @@
+#ifndef ACTIVITY
+#define ACTIVITY
+
+#include "particles.hpp"
+
+// Indices of the particles the PBF passes iterate over this step.
+// Particles whose velocity and density error stay calm for several steps fall
+// asleep, they still act as neighbors but are not moved until an active
+// neighbor or the mouse interaction disturbs them.
+extern alignas(64) int activeIndices[PARTICLES_NUMBER];
+extern int activeCount;
+
+void updateActivity();
+void wakeAll();
+bool isAsleep(const int& Index);
+bool isDisturbed(const int& Index);
+
+#endif
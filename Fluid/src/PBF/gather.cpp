@@ -0,0 +1,139 @@
+#include "gather.hpp"
+
+static_assert(!(batchedGather && pairwiseEvaluation), "batched gather and pairwise evaluation are exclusive");
+
+static NeighborBatch batches[PARTICLES_NUMBER];
+
+// the lambda pass also evaluates the gradient at the offsets shifted by +-epsilon
+static constexpr float gatherRadius = influenceRadius + 2.0f * epsilon;
+
+static bool gather(const int& Index, NeighborBatch& batch)
+{
+	const vec2 pos = prediction[Index];
+	int n = 0;
+	bool fits = true;
+
+	forEachNeighbor(Index, pos, [&](const int& j)
+	{
+		const vec2 vector = pos - prediction[j];
+		if (length2(vector) >= gatherRadius * gatherRadius) return;
+
+		if (n == batchCapacity)
+		{
+			fits = false;
+			return;
+		}
+		batch.index[n] = j;
+		batch.dx[n] = vector.x;
+		batch.dy[n] = vector.y;
+		n++;
+	});
+
+	batch.count = fits ? n : -1;
+	return fits;
+}
+
+template <typename Kernel>
+void gatherLambda(const int& Index)
+{
+	NeighborBatch& batch = batches[Index];
+	if (!gather(Index, batch))
+	{
+		calcLambda<Kernel>(Index);
+		return;
+	}
+
+	float density = 0.0f;
+	float bottom = scene.relaxation;
+
+	#pragma omp simd reduction(+:density, bottom)
+	for (int k = 0; k < batch.count; ++k)
+	{
+		const float dx = batch.dx[k];
+		const float dy = batch.dy[k];
+		const float dst = glm::sqrt(dx * dx + dy * dy);
+
+		const float plus = glm::sqrt((dx + epsilon) * (dx + epsilon) + (dy + epsilon) * (dy + epsilon));
+		const float minus = glm::sqrt((dx - epsilon) * (dx - epsilon) + (dy - epsilon) * (dy - epsilon));
+		const float cp = Kernel::gradient::gradientCoeff(plus);
+		const float cm = Kernel::gradient::gradientCoeff(minus);
+
+		batch.value[k] = Kernel::density::value(dst);
+		batch.coeff[k] = Kernel::gradient::gradientCoeff(dst);
+
+		density += mass * batch.value[k];
+		bottom += cm * cm * minus * minus + cp * cp * plus * plus;
+	}
+
+	densityErrors[Index] = density / targetDensity - 1.0f;
+	lambdas[Index] = -densityErrors[Index] / (bottom / targetDensity);
+}
+
+template <typename Kernel>
+vec2 gatherDeltaPosition(const int& Index)
+{
+	const float vfp = Kernel::density::value(scene.deltaQ);
+	const float tensileK = scene.tensileK;
+
+	// the batch loop is written for the default exponent, other ones take the scalar path
+	const NeighborBatch& batch = batches[Index];
+	if (batch.count < 0 || scene.tensileN != 4.0f) return calcDeltaPosition<Kernel>(Index);
+
+	// the only indirect loads of the pass
+	alignas(64) float neighborLambdas[batchCapacity];
+	for (int k = 0; k < batch.count; ++k)
+	{
+		neighborLambdas[k] = lambdas[batch.index[k]];
+	}
+
+	const float lambda = lambdas[Index];
+	float dx = 0.0f;
+	float dy = 0.0f;
+
+	#pragma omp simd reduction(+:dx, dy)
+	for (int k = 0; k < batch.count; ++k)
+	{
+		float s_corr = batch.value[k] / vfp;
+		s_corr *= s_corr;
+		s_corr *= s_corr;
+		s_corr *= -tensileK;
+
+		const float coeff = (lambda + neighborLambdas[k] + s_corr) * batch.coeff[k];
+
+		dx += coeff * batch.dx[k];
+		dy += coeff * batch.dy[k];
+	}
+
+	return vec2(dx, dy);
+}
+
+template <typename Kernel>
+vec2 gatherVorticityAndViscosity(const int& Index)
+{
+	// positions moved since the last lambda pass
+	NeighborBatch& batch = batches[Index];
+	if (!gather(Index, batch)) return calcVorticityAndViscosity<Kernel>(Index);
+
+	float x = 0.0f;
+	float y = 0.0f;
+
+	#pragma omp simd reduction(+:x, y)
+	for (int k = 0; k < batch.count; ++k)
+	{
+		const float dx = batch.dx[k];
+		const float dy = batch.dy[k];
+		const float dst = glm::sqrt(dx * dx + dy * dy);
+
+		const float influence = Kernel::viscosity::value(dst) * scene.viscosity;
+		const float coeff = Kernel::gradient::gradientCoeff(dst);
+
+		x += -dx * influence - coeff * dy;
+		y += -dy * influence + coeff * dx;
+	}
+
+	return vec2(x, y);
+}
+
+template void gatherLambda<SolverKernel>(const int& Index);
+template vec2 gatherDeltaPosition<SolverKernel>(const int& Index);
+template vec2 gatherVorticityAndViscosity<SolverKernel>(const int& Index);
@@ -0,0 +1,30 @@
+#ifndef GATHER
+#define GATHER
+
+#include "particles.hpp"
+
+// Batched evaluation of the PBF passes. The lambda pass copies every active
+// particle's neighbors within the influence radius into a per-particle SoA
+// batch: offsets, density kernel values and gradient coefficients. The delta
+// pass of the same iteration then gathers only the neighbor lambdas and runs
+// over those dense arrays. Particles with more than batchCapacity neighbors
+// fall back to the per-neighbor functions.
+
+static constexpr int batchCapacity = 64;
+
+struct alignas(64) NeighborBatch
+{
+	int count = 0;	// -1 when the neighbors did not fit
+
+	alignas(64) int   index[batchCapacity];
+	alignas(64) float dx[batchCapacity];
+	alignas(64) float dy[batchCapacity];
+	alignas(64) float value[batchCapacity];
+	alignas(64) float coeff[batchCapacity];
+};
+
+template <typename Kernel> void gatherLambda(const int& Index);
+template <typename Kernel> vec2 gatherDeltaPosition(const int& Index);
+template <typename Kernel> vec2 gatherVorticityAndViscosity(const int& Index);
+
+#endif
@@ -0,0 +1,111 @@
+#include "multirate.hpp"
+#include "activity.hpp"
+
+static constexpr float multirate_cfl   = 0.02f;
+static constexpr int   substeps        = 1 << (multirateLevels - 1);
+
+alignas(64) int levels[PARTICLES_NUMBER];
+MultirateStats multirateStats;
+
+alignas(64) static int awakeIndices[PARTICLES_NUMBER];
+alignas(64) static int levelsNext[PARTICLES_NUMBER];
+static int awakeCount = 0;
+
+void multirateUpdate()
+{
+	updateActivity();
+
+	awakeCount = activeCount;
+	std::copy(activeIndices, activeIndices + activeCount, awakeIndices);
+
+	assignLevels();
+
+	for (int s = 0; s < substeps; ++s)
+	{
+		interpolateInactive(s);
+
+		// a particle finishes its step when the substep closes its level's interval
+		activeCount = 0;
+		for (int k = 0; k < awakeCount; ++k)
+		{
+			const int i = awakeIndices[k];
+			const int interval = substeps >> levels[i];
+
+			if ((s + 1) % interval == 0)
+			{
+				stepSizes[i] = scene.dt / (1 << levels[i]);
+				activeIndices[activeCount++] = i;
+			}
+		}
+
+		if (activeCount > 0) particlesSolve();
+		multirateStats.updates += activeCount;
+	}
+	multirateStats.fineUpdates += static_cast<long long>(awakeCount) * substeps;
+}
+void assignLevels()
+{
+	static const float bound = multirate_cfl * radius;
+
+	// local CFL: the distance covered in one step of level k has to stay below the bound
+	#pragma omp parallel for schedule(static) num_threads(scene.threads)
+	for (int k = 0; k < awakeCount; ++k)
+	{
+		const int i = awakeIndices[k];
+		const float travel = glm::length(particles.dir[i]) * scene.dt;
+
+		int level = 0;
+		if (travel > bound) level = static_cast<int>(std::ceil(std::log2(travel / bound)));
+		levels[i] = glm::clamp(level, 0, multirateLevels - 1);
+	}
+
+	// neighbors differ by at most one level so interpolation spans short intervals
+	#pragma omp parallel for schedule(static) num_threads(scene.threads)
+	for (int k = 0; k < awakeCount; ++k)
+	{
+		const int i = awakeIndices[k];
+		int level = levels[i];
+
+		forEachNeighbor(i, prediction[i], [&](const int& j)
+		{
+			if (!isAsleep(j)) level = std::max(level, levels[j] - 1);
+		});
+		levelsNext[i] = level;
+	}
+
+	std::fill(multirateStats.frameLevels, multirateStats.frameLevels + multirateLevels, 0);
+	for (int k = 0; k < awakeCount; ++k)
+	{
+		const int i = awakeIndices[k];
+		levels[i] = levelsNext[i];
+		multirateStats.frameLevels[levels[i]]++;
+	}
+	for (int l = 0; l < multirateLevels; ++l) multirateStats.levelCounts[l] += multirateStats.frameLevels[l];
+}
+void interpolateInactive(const int& substep)
+{
+	// positions at the end of this substep for particles still inside their own step
+	#pragma omp parallel for schedule(static) num_threads(scene.threads)
+	for (int k = 0; k < awakeCount; ++k)
+	{
+		const int i = awakeIndices[k];
+		const int interval = substeps >> levels[i];
+		const int elapsed = (substep + 1) % interval;
+
+		if (elapsed == 0) continue;
+
+		vec2 shift = particles.dir[i] * (elapsed * scene.dt / substeps);
+
+		prediction[i] = particles.centers[i];
+		boundaryCondition(i, shift);
+		prediction[i] += shift;
+
+		newUpdateSegment(i);
+	}
+	refreshNeighborSearch(prediction);
+}
+float multirateSpeedup()
+{
+	if (multirateStats.updates == 0) return 1.0f;
+	return static_cast<float>(multirateStats.fineUpdates) / multirateStats.updates;
+}
@@ -0,0 +1,29 @@
+#ifndef MULTIRATE
+#define MULTIRATE
+
+#include "particles.hpp"
+
+// Local time stepping for PBF: every frame of length dt is split into
+// 2^(multirateLevels - 1) substeps and a particle of level k advances with a
+// step of dt / 2^k. Particles that are between their own steps are seen by
+// their neighbors at positions interpolated along their current velocity.
+
+// Counters since the start; frameLevels is the level distribution of the
+// particles awake in the last frame. The solver only counts, drivers report.
+struct MultirateStats
+{
+	long long updates = 0;
+	long long fineUpdates = 0;
+	long long levelCounts[multirateLevels] = { 0 };
+	int frameLevels[multirateLevels] = { 0 };
+};
+
+extern alignas(64) int levels[PARTICLES_NUMBER];
+extern MultirateStats multirateStats;
+
+void multirateUpdate();
+void assignLevels();
+void interpolateInactive(const int& substep);
+float multirateSpeedup();
+
+#endif
@@ -0,0 +1,177 @@
+#include "pairwise.hpp"
+#include "activity.hpp"
+
+static_assert(!pairwiseEvaluation || neighborSearch == NeighborSearch::Segments,
+	"the half stencil walks the segments grid cell by cell");
+
+alignas(64) vec2 pairwiseVectors[PARTICLES_NUMBER];
+
+alignas(64) static float accDensity[threads][PARTICLES_NUMBER];
+alignas(64) static float accBottom[threads][PARTICLES_NUMBER];
+alignas(64) static vec2  accVector[threads][PARTICLES_NUMBER];
+
+alignas(64) static bool activeMask[PARTICLES_NUMBER];
+
+template <typename Func>
+inline void forEachPair(Func&& func)
+{
+	const int tid = omp_get_thread_num();
+
+	auto visit = [&](const int& i, const int& j)
+	{
+		if (!activeMask[i] && !activeMask[j]) return;
+
+		const vec2 vector = prediction[i] - prediction[j];
+		if (length2(vector) >= influenceRadius * influenceRadius) return;
+
+		func(tid, i, j, vector);
+	};
+
+	#pragma omp for schedule(dynamic, 4)
+	for (int cell = 0; cell < static_cast<int>(cellsSize); ++cell)
+	{
+		for (Node* a = segments.segments[cell]; a; a = a->next)
+		{
+			for (Node* b = a->next; b; b = b->next)
+			{
+				visit(a->value, b->value);
+			}
+
+			// ghost cells are empty, so only interior cells reach this and their forward cells exist
+			for (int s = 0; s < 4; ++s)
+			{
+				for (Node* b = segments.segments[cell + forwardOffsets[s]]; b; b = b->next)
+				{
+					visit(a->value, b->value);
+				}
+			}
+		}
+	}
+}
+
+void pairwiseMarkActive()
+{
+	#pragma omp for schedule(static)
+	for (int i = 0; i < PARTICLES_NUMBER; ++i)
+	{
+		activeMask[i] = false;
+	}
+
+	#pragma omp for schedule(static)
+	for (int k = 0; k < activeCount; ++k)
+	{
+		activeMask[activeIndices[k]] = true;
+	}
+}
+
+template <typename Kernel>
+void pairwiseLambdas()
+{
+	const vec2 shift(epsilon, epsilon);
+
+	forEachPair([&](const int& tid, const int& i, const int& j, const vec2& vector)
+	{
+		const vec2 plus = vector + shift;
+		const vec2 minus = vector - shift;
+
+		const scalar cp = Kernel::gradient::gradientCoeff(glm::length(plus));
+		const scalar cm = Kernel::gradient::gradientCoeff(glm::length(minus));
+
+		// |grad W(v + e)|^2 + |grad W(v - e)|^2 is the same seen from i and from j
+		const scalar density = mass * Kernel::density::value(glm::length(vector));
+		const scalar bottom = cp * cp * length2(plus) + cm * cm * length2(minus);
+
+		accDensity[tid][i] += density;
+		accDensity[tid][j] += density;
+		accBottom[tid][i] += bottom;
+		accBottom[tid][j] += bottom;
+	});
+
+	const int team = omp_get_num_threads();
+
+	#pragma omp for schedule(static)
+	for (int i = 0; i < PARTICLES_NUMBER; ++i)
+	{
+		float density = 0.0f;
+		float bottom = scene.relaxation;
+
+		for (int t = 0; t < team; ++t)
+		{
+			density += accDensity[t][i];
+			bottom += accBottom[t][i];
+
+			accDensity[t][i] = 0.0f;
+			accBottom[t][i] = 0.0f;
+		}
+
+		if (!activeMask[i]) continue;
+
+		densityErrors[i] = density / targetDensity - 1.0f;
+		lambdas[i] = -densityErrors[i] / (bottom / targetDensity);
+	}
+}
+
+static void reduceVectors()
+{
+	const int team = omp_get_num_threads();
+
+	#pragma omp for schedule(static)
+	for (int i = 0; i < PARTICLES_NUMBER; ++i)
+	{
+		vec2 sum(0.0f, 0.0f);
+
+		for (int t = 0; t < team; ++t)
+		{
+			sum += accVector[t][i];
+			accVector[t][i] = { 0.0f, 0.0f };
+		}
+		pairwiseVectors[i] = sum;
+	}
+}
+
+template <typename Kernel>
+void pairwiseDeltaPositions()
+{
+	const float vfp = Kernel::density::value(scene.deltaQ);
+
+	forEachPair([&](const int& tid, const int& i, const int& j, const vec2& vector)
+	{
+		const scalar dst = glm::length(vector);
+
+		const scalar s_corr = tensileCorrection(Kernel::density::value(dst) / vfp);
+
+		// the gradient is antisymmetric, j receives the opposite shift
+		const vec2 delta = ((lambdas[i] + lambdas[j] + s_corr) * Kernel::gradient::gradientCoeff(dst)) * vector;
+
+		accVector[tid][i] += delta;
+		accVector[tid][j] -= delta;
+	});
+
+	reduceVectors();
+}
+
+template <typename Kernel>
+void pairwiseVorticityAndViscosity()
+{
+	forEachPair([&](const int& tid, const int& i, const int& j, const vec2& vector)
+	{
+		const scalar dst = glm::length(vector);
+
+		const float influence = Kernel::viscosity::value(dst) * scene.viscosity;
+		const float coeff = Kernel::gradient::gradientCoeff(dst);
+
+		const vec2 force(
+			-vector.x * influence - coeff * vector.y,
+			-vector.y * influence + coeff * vector.x
+		);
+
+		accVector[tid][i] += force;
+		accVector[tid][j] -= force;
+	});
+
+	reduceVectors();
+}
+
+template void pairwiseLambdas<SolverKernel>();
+template void pairwiseDeltaPositions<SolverKernel>();
+template void pairwiseVorticityAndViscosity<SolverKernel>();
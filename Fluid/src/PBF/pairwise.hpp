@@ -0,0 +1,20 @@
+#ifndef PAIRWISE
+#define PAIRWISE
+
+#include "particles.hpp"
+
+// Symmetric half-stencil evaluation of the PBF passes. Every cell is paired
+// with itself and its 4 forward neighbors only, so each pair (i, j) is
+// visited once and its shared terms are scattered to both particles through
+// per-thread accumulators. Must be called from inside the solver's parallel
+// region, results are written for the particles in activeIndices.
+
+extern alignas(64) vec2 pairwiseVectors[PARTICLES_NUMBER];
+
+void pairwiseMarkActive();
+
+template <typename Kernel> void pairwiseLambdas();
+template <typename Kernel> void pairwiseDeltaPositions();
+template <typename Kernel> void pairwiseVorticityAndViscosity();
+
+#endif
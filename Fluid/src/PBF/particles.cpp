@@ -1,26 +1,19 @@
 #include "particles.hpp"
-
-static constexpr float coeff       = 1.0f / scale;
-static constexpr float epsilon     = 0.000001f;
-static constexpr float dt          = 0.1f;
-static constexpr float resistance  = 0.9f;
-static constexpr float gravity     = 30.0f;
-static constexpr float viscosity_c = 0.04f;
-static constexpr float relaxation  = 3e-6f;
-static constexpr float delta_q     = 0.03f;
-static constexpr int   iterations  = 20;
-
-static constexpr float collision_penalty      = 0.01f;
-static constexpr float tensible_instability_k = 0.1f;
-static constexpr float tensible_instability_n = 4.0f;
+#include "activity.hpp"
+#include "pairwise.hpp"
+#include "gather.hpp"
+#include "multirate.hpp"
+#include "../IISPH/iisph.hpp"
+#include "../Scene/layout.hpp"
 
 alignas(64) Particles particles;
-alignas(64) List       segments;
 
 alignas(64) vec2 prediction[PARTICLES_NUMBER];
 alignas(64) vec2   external[PARTICLES_NUMBER];
 
 alignas(64) float   lambdas[PARTICLES_NUMBER];
+alignas(64) float   densityErrors[PARTICLES_NUMBER];
+alignas(64) float   stepSizes[PARTICLES_NUMBER];
 
 alignas(64) vec2     interactionInputPoint(0.0, 0.0);
 alignas(64) float    interactionInputStrength = 0.0 ;
@@ -29,92 +22,115 @@ void particlesUpdate()
 {
 	//Timer global; global.emerge();
 
-	#pragma omp parallel num_threads(threads)
+	updateActivity();
+	particlesSolve();
+
+	//DBG::print(global.done(), "");
+}
+void stepSimulation()
+{
+	maintainNeighborSearch(prediction);
+
+	if constexpr (solver == Solver::IISPH) iisphUpdate();
+	else if constexpr (multirateStepping) multirateUpdate();
+	else particlesUpdate();
+}
+void particlesSolve()
+{
+	#pragma omp parallel num_threads(scene.threads)
 	{
+		if constexpr (pairwiseEvaluation) pairwiseMarkActive();
+
 		#pragma omp for schedule(dynamic, PARTICLES_NUMBER / threads)
-		for (int i = 0; i < PARTICLES_NUMBER; ++i)
+		for (int k = 0; k < activeCount; ++k)
 		{
-			external[i] *= resistance;
-			external[i] += ExternalForces(particles.centers[i], particles.dir[i]) * dt;
+			const int i = activeIndices[k];
+			const float step = stepSizes[i];
+
+			external[i] *= (step == scene.dt) ? scene.resistance : std::pow(scene.resistance, step / scene.dt);
+			external[i] += ExternalForces(particles.centers[i], particles.dir[i]) * step;
 
 			particles.dir[i] += external[i];
 			prediction[i] = particles.centers[i];
 
-			vec2 shift = particles.dir[i] * dt;
+			vec2 shift = particles.dir[i] * step;
 			collisionHandler(i, shift);
 
 			prediction[i] += shift;
-			newUpdateSegment(
-				i, GetSegmentIndex(particles.centers[i]), GetSegmentIndex(prediction[i])
-			);
+			newUpdateSegment(i);
 
 		}
+		refreshNeighborSearch(prediction);
 
-		for (int j = 0; j < iterations; ++j)
+		for (int j = 0; j < scene.iterations; ++j)
 		{
-			// Fill arrays values
-			#pragma omp for schedule(dynamic, PARTICLES_NUMBER / (2 * threads))
-			for (int i = 0; i < PARTICLES_NUMBER; ++i)
+			if constexpr (pairwiseEvaluation)
 			{
-				calcLambda(i);
+				// all shifts are gathered before any prediction moves
+				pairwiseLambdas<SolverKernel>();
+				pairwiseDeltaPositions<SolverKernel>();
+			}
+			else
+			{
+				// Fill arrays values
+				#pragma omp for schedule(dynamic, PARTICLES_NUMBER / (2 * threads))
+				for (int k = 0; k < activeCount; ++k)
+				{
+					if constexpr (batchedGather) gatherLambda<SolverKernel>(activeIndices[k]);
+					else calcLambda<SolverKernel>(activeIndices[k]);
+				}
 			}
 
 			// Compute position shift
 			#pragma omp for schedule(dynamic, PARTICLES_NUMBER / (2 * threads))
-			for (int i = 0; i < PARTICLES_NUMBER; ++i)
+			for (int k = 0; k < activeCount; ++k)
 			{
-				vec2 deltaPosition = calcDeltaPosition(i);
-				int unit = GetSegmentIndex(prediction[i]);
+				const int i = activeIndices[k];
+
+				vec2 deltaPosition;
+				if constexpr (pairwiseEvaluation) deltaPosition = pairwiseVectors[i];
+				else if constexpr (batchedGather) deltaPosition = gatherDeltaPosition<SolverKernel>(i);
+				else deltaPosition = calcDeltaPosition<SolverKernel>(i);
 
 				collisionHandler(i, deltaPosition);
 				prediction[i] += deltaPosition;
 
-				newUpdateSegment(
-					i, unit,
-					GetSegmentIndex(prediction[i])
-				);
+				newUpdateSegment(i);
 			}
+			refreshNeighborSearch(prediction);
 		}
 
+		if constexpr (pairwiseEvaluation) pairwiseVorticityAndViscosity<SolverKernel>();
+
 		#pragma omp for schedule(dynamic, PARTICLES_NUMBER / (4 * threads))
-		for (int i = 0; i < PARTICLES_NUMBER; ++i)
+		for (int k = 0; k < activeCount; ++k)
 		{
-			vec2 force = calcVorticityAndViscosity(i);
-			particles.dir[i] = (prediction[i] - particles.centers[i]) * dt;
+			const int i = activeIndices[k];
+
+			vec2 force;
+			if constexpr (pairwiseEvaluation) force = pairwiseVectors[i];
+			else if constexpr (batchedGather) force = gatherVorticityAndViscosity<SolverKernel>(i);
+			else force = calcVorticityAndViscosity<SolverKernel>(i);
+			particles.dir[i] = (prediction[i] - particles.centers[i]) * (scene.dt * scene.dt / stepSizes[i]);
 
 			particles.dir[i] += force;
 			particles.centers[i] = prediction[i];
 
 		}
 	}
-
-	//DBG::print(global.done(), "");
 }
-void newUpdateSegment(const int& i, const int& pre, const int& post)
+// the grid follows prediction, which multirate stepping may have interpolated
+void newUpdateSegment(const int& i)
 {
-	if (pre != post)
-	{
-		#pragma omp critical
-		{
-			if (segments.indices[i].next)
-			{
-				segments.indices[i].next->prev = segments.indices[i].prev;
-			}
-			if (segments.indices[i].prev)
-			{
-				segments.indices[i].prev->next = segments.indices[i].next;
-			}
-			else segments.segments[pre] = segments.indices[i].next;
+	if constexpr (neighborSearch != NeighborSearch::Segments) return;
 
-			segments.indices[i].next = segments.segments[post];
-			segments.indices[i].prev = nullptr;
+	const int pre = segmentIndices[i];
+	const int post = GetSegmentIndex(prediction[i]);
 
-			if (segments.segments[post])
-			{
-				segments.segments[post]->prev = segments.indices + i;
-			}
-			segments.segments[post] = segments.indices + i;
-		}
+	if (pre != post)
+	{
+		segmentIndices[i] = post;
+		recordSegmentMove(i, pre, post);
 	}
 }
 void sort()
@@ -155,40 +171,29 @@ void sort()
 		}
 	}
 }
-void initParticles()
+bool initParticles()
 {
-	srand(time(NULL));
+	if (!generateLayout(scene, particles.centers)) return false;
 
-	static constexpr int internal_margin = 2;
-	//DBG::print(cellsSize, "segment number ");
+	#pragma omp parallel for num_threads(scene.threads)
 	for (int i = 0; i < PARTICLES_NUMBER; ++i)
 	{
-		float x = (BOXMARGINX + internal_margin + rand() % (BOXWIDTH - 2 * internal_margin)) * coeff;
-		float y = (BOXMARGINY + internal_margin + rand() % (BOXHEIGHT - 2 * internal_margin)) * coeff;
-
-		particles.centers[i] = { x, y };
-		prediction[i] = { x, y };
+		prediction[i] = particles.centers[i];
+		particles.dir[i] = { 0.0, 0.0 };
 
 		external[i] = { 0.0, 0.0 };
+		stepSizes[i] = scene.dt;
+		smoothingLengths[i] = influenceRadius;
 	}
 
 	//sort();
 	distribute();
+	refreshNeighborSearch(prediction);
+	return true;
 }
 void distribute()
 {
-	for (int i = 0; i < PARTICLES_NUMBER; ++i)
-	{
-		unsigned unit = GetSegmentIndex(particles.centers[i]);
-		segments.indices[i].next = segments.segments[unit];
-		if (segments.segments[unit] != nullptr)
-		{
-			segments.segments[unit]->prev = &segments.indices[i];
-		}
-		segments.segments[unit] = &segments.indices[i];
-
-		segments.segments[unit]->value = i;
-	}
+	buildSegments(particles.centers);
 }
 
 void collisionResponse(const vec2& pos, const int& Index)
@@ -200,20 +205,20 @@ void collisionResponse(const vec2& pos, const int& Index)
 
 	if (relative_pos.x <= 0.0)
 	{
-		external[Index].x += -collision_penalty * relative_pos.x;
+		external[Index].x += -scene.collisionPenalty * relative_pos.x;
 	}
 	else if (relative_pos.x >= BOXWIDTH)
 	{
-		external[Index].x += -collision_penalty * (relative_pos.x - BOXWIDTH);
+		external[Index].x += -scene.collisionPenalty * (relative_pos.x - BOXWIDTH);
 	}
 
 	if (relative_pos.y <= 0.0)
 	{
-		external[Index].y += -collision_penalty * relative_pos.y;
+		external[Index].y += -scene.collisionPenalty * relative_pos.y;
 	}
 	else if (relative_pos.y >= BOXHEIGHT)
 	{
-		external[Index].y += -collision_penalty * (relative_pos.y - BOXHEIGHT);
+		external[Index].y += -scene.collisionPenalty * (relative_pos.y - BOXHEIGHT);
 	}
 }
 void boundaryCondition(const int& Index, vec2& dp)
@@ -251,133 +256,99 @@ void collisionHandler(const int& Index, vec2& dp)
 	boundaryCondition(Index, dp);
 }
 
+template <typename Kernel>
 inline vec2 calcGradient(const int& Index, const int& k)
 {
 	const vec2 shift(epsilon, epsilon);
 
-	const vec2 vector = prediction[Index] - prediction[k];
-	return -KernelVersion_1::calcPoly6Gradient(vector - shift);
+	const vec2 vector = prediction[Index] - prediction[k] - shift;
+	return -Kernel::gradient::gradientCoeff(glm::length(vector)) * vector;
 }
+template <typename Kernel>
 inline scalar calcGradientLength2(const int& Index, const int& k)
 {
 	const vec2 shift(epsilon, epsilon);
 
-	const vec2 vector = prediction[Index] - prediction[k];
-	const scalar dst = glm::length(vector - shift);
-
-	const scalar x = KernelVersion_1::calcPoly6DerivativeX(dst, vector.x - shift.x);
-	const scalar y = KernelVersion_1::calcPoly6DerivativeY(dst, vector.y - shift.y);
+	const vec2 vector = prediction[Index] - prediction[k] - shift;
+	const scalar coeff = Kernel::gradient::gradientCoeff(glm::length(vector));
 
-	return x * x + y * y;
+	return coeff * coeff * glm::dot(vector, vector);
 }
 
+template <typename Kernel>
 void calcLambda(const int& Index)
 {
 	const vec2 shift(epsilon, epsilon);
 
 	alignas(64) float density = 0.0;
-	alignas(64) float bottom = relaxation;
+	alignas(64) float bottom = scene.relaxation;
 
-	const unsigned segInd = GetSegmentIndex(prediction[Index]);
-
-	// #pragma omp parallel for firstprivate(segInd, mass, influenceRadius) reduction(+:density) reduction(+:bottom) schedule(static) num_threads(1)
-	for (int locShift = 0; locShift < 9; locShift++)
+	forEachNeighbor(Index, prediction[Index], [&](const int& j)
 	{
-		const int location = GetLocationFromShift(segInd, locShift);
-		if (location < 0) continue;
-
-		for (Node* seg = segments.segments[location]; seg; seg = seg->next)
-		{
-			if (Index == seg->value) continue;
-
-			const vec2 vector = prediction[Index] - prediction[seg->value];
-			const scalar dst = glm::length(vector + shift);
-
-			const scalar x = KernelVersion_1::calcPoly6DerivativeX(dst, vector.x + shift.x);
-			const scalar y = KernelVersion_1::calcPoly6DerivativeY(dst, vector.y + shift.y);
-
-			// calculate density
-			density += mass * KernelVersion_1::calcPoly6(glm::length(vector));
-			bottom += calcGradientLength2(Index, seg->value) + x * x + y * y;
-		}
-	}
-	lambdas[Index] = -(density / targetDensity - 1.0f) / (bottom / targetDensity);
+		const vec2 vector = prediction[Index] - prediction[j];
+		const scalar dst = glm::length(vector + shift);
+		const scalar coeff = Kernel::gradient::gradientCoeff(dst);
+
+		// calculate density
+		density += mass * Kernel::density::value(glm::length(vector));
+		bottom += calcGradientLength2<Kernel>(Index, j) + coeff * coeff * dst * dst;
+	});
+	densityErrors[Index] = density / targetDensity - 1.0f;
+	lambdas[Index] = -densityErrors[Index] / (bottom / targetDensity);
 }
 
+template <typename Kernel>
 vec2 calcDeltaPosition(const int& Index)
 {
-	static const float vfp = KernelVersion_1::calcPoly6(delta_q);
+	const float vfp = Kernel::density::value(scene.deltaQ);
 
 	alignas(64) float dx = 0.0;
 	alignas(64) float dy = 0.0;
 
-	unsigned segInd = GetSegmentIndex(prediction[Index]);
-
-	// #pragma omp parallel for firstprivate(segInd, tensible_instability_k, tensible_instability_n, vfp) reduction(+:dx) reduction(+:dy) schedule(dynamic) num_threads(9)
-	for (int locShift = 0; locShift < 9; locShift++)
+	forEachNeighbor(Index, prediction[Index], [&](const int& j)
 	{
-		int location = GetLocationFromShift(segInd, locShift);
-		if (location < 0) continue;
-
-		for (Node* seg = segments.segments[location]; seg; seg = seg->next)
-		{
-			if (seg->value == Index) continue;
-
-			vec2 dir = prediction[Index] - prediction[seg->value];
-			scalar dst = glm::length(dir);
-			scalar left, s_corr;
+		vec2 dir = prediction[Index] - prediction[j];
+		scalar dst = glm::length(dir);
+		scalar left, s_corr;
 
-			left = lambdas[Index] + lambdas[seg->value];
+		left = lambdas[Index] + lambdas[j];
 
-			s_corr = KernelVersion_1::calcPoly6(dst);
-			s_corr /= vfp;
+		s_corr = tensileCorrection(Kernel::density::value(dst) / vfp);
 
-			s_corr *= s_corr;
-			s_corr *= s_corr;
-			s_corr *= -tensible_instability_k;
+		const scalar coeff = (left + s_corr) * Kernel::gradient::gradientCoeff(dst);
 
-			dx += (left + s_corr) * KernelVersion_1::calcPoly6DerivativeX(dst, dir.x);
-			dy += (left + s_corr) * KernelVersion_1::calcPoly6DerivativeY(dst, dir.y);
-		}
-	}
+		dx += coeff * dir.x;
+		dy += coeff * dir.y;
+	});
 
 	return vec2(dx, dy);
 }
+template <typename Kernel>
 vec2 calcVorticityAndViscosity(const int& Index)
 {
 	alignas(64) float x = 0.0;
 	alignas(64) float y = 0.0;
 
-	unsigned segInd = GetSegmentIndex(prediction[Index]);
-
-	//#pragma omp parallel for firstprivate(segInd, viscosity_c) reduction(+:x) reduction(+:y) schedule(static) num_threads(1)
-	for (int locShift = 0; locShift < 9; locShift++)
+	forEachNeighbor(Index, prediction[Index], [&](const int& j)
 	{
-		int location = GetLocationFromShift(segInd, locShift);
-		if (location < 0) continue;
-
-		for (Node* seg = segments.segments[location]; seg; seg = seg->next)
-		{
-			if (seg->value == Index) continue;
-
-			// vorticity confinement
-			vec2 dir = prediction[Index] - prediction[seg->value];
-			float dst = glm::length(dir);
+		// vorticity confinement
+		vec2 dir = prediction[Index] - prediction[j];
+		float dst = glm::length(dir);
 
-			// viscosity
-			float influence = KernelVersion_1::calcViscosityKernel(dst);
+		// viscosity
+		float influence = Kernel::viscosity::value(dst);
+		float coeff = Kernel::gradient::gradientCoeff(dst);
 
-			x += -dir.x * influence * viscosity_c - KernelVersion_1::calcPoly6DerivativeY(dst, dir.y);;
-			y += -dir.y * influence * viscosity_c + KernelVersion_1::calcPoly6DerivativeX(dst, dir.x);
-		}
-	}
+		x += -dir.x * influence * scene.viscosity - coeff * dir.y;
+		y += -dir.y * influence * scene.viscosity + coeff * dir.x;
+	});
 	//std::cout << x << " " << y << std::endl;
 	return vec2(x, y);
 }
 vec2 ExternalForces(const vec2& pos, const vec2& velocity)
 {
 	// Gravity
-	vec2 gravityAccel(0, -gravity);
+	vec2 gravityAccel(0, -scene.gravity);
 
 	// Input interactions modify gravity
 	if (interactionInputStrength != 0) {
@@ -398,3 +369,7 @@ vec2 ExternalForces(const vec2& pos, const vec2& velocity)
 
 	return gravityAccel;
 }
+
+template void calcLambda<SolverKernel>(const int& Index);
+template vec2 calcDeltaPosition<SolverKernel>(const int& Index);
+template vec2 calcVorticityAndViscosity<SolverKernel>(const int& Index);
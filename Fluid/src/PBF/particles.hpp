@@ -3,17 +3,30 @@
 
 #include "../math/minmath.hpp"
 #include "../settings.hpp"
-#include "../NearestNeighborSearch/segments.hpp"
-#include "../math/kernelFunctions.hpp"
+#include "../Scene/scene.hpp"
+#include "../NearestNeighborSearch/neighbors.hpp"
+#include "../math/kernelTables.hpp"
 #include "../Debug/prints.hpp"
 #include "../Debug/timer.hpp"
 
 #include <random>
+#include <cmath>
 #include <iostream>
 #include <array>
 #include <time.h>
 #include <omp.h>
 
+static constexpr float coeff       = 1.0f / scale;
+static constexpr float epsilon     = 0.000001f;
+
+// tensile instability term -k (W(r) / W(delta_q))^n of the ratio W(r) / W(delta_q),
+// the default n = 4 stays two squarings
+inline float tensileCorrection(const float& ratio)
+{
+	const float squared = ratio * ratio;
+	return -scene.tensileK * (scene.tensileN == 4.0f ? squared * squared : std::pow(ratio, scene.tensileN));
+}
+
 struct Particle
 {
 	alignas(64) Point& center;
@@ -32,23 +45,32 @@ struct Particles
 
 extern Particles particles;
 
+extern alignas(64) vec2 prediction[PARTICLES_NUMBER];
+extern alignas(64) vec2   external[PARTICLES_NUMBER];
+
 extern alignas(64) float lambdas[PARTICLES_NUMBER];
+extern alignas(64) float densityErrors[PARTICLES_NUMBER];
+extern alignas(64) float stepSizes[PARTICLES_NUMBER];
 extern alignas(64) float interactionInputStrength;
 extern alignas(64) vec2  interactionInputPoint;
 
-void newUpdateSegment(const int& i, const int& pre, const int& post);
+void newUpdateSegment(const int& i);
 void collisionResponse(const vec2& pos, const int& Index);
 void boundaryCondition(const int& Index, vec2& dp);
 void collisionHandler(const int& Index, vec2& dp);
-void calcLambda(const int& Index);
+template <typename Kernel> void calcLambda(const int& Index);
 void particlesUpdate();
-void initParticles();
+// one frame of the configured solver, the neighbor search maintenance included
+void stepSimulation();
+void particlesSolve();
+// positions from the scene's [init] layout, false when it cannot be generated
+bool initParticles();
 void distribute();
 void sort();
 
-vec2 calcDeltaPosition(const int& Index);
-vec2 calcGradient(const int& Index, const int& k);
-vec2 calcVorticityAndViscosity(const int& Index);
+template <typename Kernel> vec2 calcDeltaPosition(const int& Index);
+template <typename Kernel> vec2 calcGradient(const int& Index, const int& k);
+template <typename Kernel> vec2 calcVorticityAndViscosity(const int& Index);
 vec2 ExternalForces(const vec2& pos, const vec2& velocity);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,225 @@
+#include "layout.hpp"
+#include "../PBF/particles.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static const vec2 boxOrigin(BOXMARGINX * coeff, BOXMARGINY * coeff);
+static const vec2 boxSize(BOXWIDTH * coeff, BOXHEIGHT * coeff);
+
+// poisson dart throwing: tiles of 2 x 2 cells, rounds over all tiles, darts per tile and round
+static constexpr int poissonTileCells = 2;
+static constexpr int poissonRounds = 8;
+static constexpr int poissonDarts = 8;
+
+// splitmix64 finaliser as a counter based generator
+static uint64_t mix(uint64_t x)
+{
+	x += 0x9E3779B97F4A7C15ull;
+	x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+	x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+	return x ^ (x >> 31);
+}
+// uniform in [0, 1)
+static float uniform(const uint64_t& seed, const uint64_t& index)
+{
+	return static_cast<float>(mix(seed ^ mix(index)) >> 40) * (1.0f / 16777216.0f);
+}
+
+static bool randomLayout(const SceneConfig& config, const uint64_t& seed, vec2* positions)
+{
+	const float margin = 2.0f * coeff;
+	const vec2 extent(boxSize.x * config.fillWidth - 2.0f * margin, boxSize.y - 2.0f * margin);
+
+	#pragma omp parallel for num_threads(config.threads)
+	for (int i = 0; i < PARTICLES_NUMBER; ++i)
+	{
+		positions[i] = boxOrigin + margin + vec2(uniform(seed, 2 * i), uniform(seed, 2 * i + 1)) * extent;
+	}
+	return true;
+}
+
+static bool latticeLayout(const SceneConfig& config, const uint64_t& seed, const float& spacing, const bool& hexagonal, vec2* positions)
+{
+	const float rowStep = hexagonal ? spacing * std::sqrt(3.0f) * 0.5f : spacing;
+	const float width = boxSize.x * config.fillWidth - (hexagonal ? 0.5f * spacing : 0.0f);
+
+	const int columns = static_cast<int>(width / spacing);
+	const int rows = columns > 0 ? (PARTICLES_NUMBER + columns - 1) / columns : 0;
+
+	if (columns < 1 || spacing + (rows - 1) * rowStep > boxSize.y)
+	{
+		std::cerr << "layout: " << PARTICLES_NUMBER << " particles at spacing " << spacing
+			<< " do not fit the box, lower spacing or raise fill_width" << std::endl;
+		return false;
+	}
+
+	const float displacement = 2.0f * config.jitter * spacing;
+
+	#pragma omp parallel for num_threads(config.threads)
+	for (int i = 0; i < PARTICLES_NUMBER; ++i)
+	{
+		const int row = i / columns;
+		const int column = i % columns;
+		const float shift = hexagonal && (row & 1) ? 0.5f : 0.0f;
+
+		vec2 p((column + 0.5f + shift) * spacing, 0.5f * spacing + row * rowStep);
+		if (displacement > 0.0f) p += (vec2(uniform(seed, 2 * i), uniform(seed, 2 * i + 1)) - 0.5f) * displacement;
+
+		positions[i] = boxOrigin + p;
+	}
+	return true;
+}
+
+// Dart throwing on a background grid of r / sqrt(2) cells, each holding at
+// most one particle. A dart only looks two cells around its own, so tiles of
+// 2 x 2 cells that share a parity are never closer than a particle can see
+// and the four parity classes are filled one after another, each in parallel.
+// The darts of a tile come from the tile's own counters, which keeps the
+// result independent of the thread count.
+static bool poissonLayout(const SceneConfig& config, const uint64_t& seed, const float& spacing, vec2* positions)
+{
+	const float cell = spacing / std::sqrt(2.0f);
+	const vec2 extent(boxSize.x * config.fillWidth - spacing, boxSize.y - spacing);
+
+	const int gx = static_cast<int>(std::ceil(extent.x / cell));
+	const int gy = static_cast<int>(std::ceil(extent.y / cell));
+	const int tx = (gx + poissonTileCells - 1) / poissonTileCells;
+	const int ty = (gy + poissonTileCells - 1) / poissonTileCells;
+
+	if (gx < 1 || gy < 1)
+	{
+		std::cerr << "layout: spacing " << spacing << " leaves no room in the box" << std::endl;
+		return false;
+	}
+
+	std::vector<vec2> samples(static_cast<size_t>(gx) * gy);
+	std::vector<char> occupied(samples.size(), 0);
+	const float r2 = spacing * spacing;
+
+	for (int round = 0; round < poissonRounds; ++round)
+	{
+		for (int parity = 0; parity < 4; ++parity)
+		{
+			#pragma omp parallel for schedule(dynamic) num_threads(config.threads)
+			for (int t = 0; t < tx * ty; ++t)
+			{
+				const int a = t % tx;
+				const int b = t / tx;
+				if ((a & 1) != (parity & 1) || (b & 1) != (parity >> 1)) continue;
+
+				for (int dart = 0; dart < poissonDarts; ++dart)
+				{
+					const uint64_t index = ((static_cast<uint64_t>(t) * poissonRounds + round) * poissonDarts + dart) * 2;
+					const vec2 p = (vec2(a, b) + vec2(uniform(seed, index), uniform(seed, index + 1))) * (poissonTileCells * cell);
+					if (p.x >= extent.x || p.y >= extent.y) continue;
+
+					const int cx = std::min(static_cast<int>(p.x / cell), gx - 1);
+					const int cy = std::min(static_cast<int>(p.y / cell), gy - 1);
+					if (occupied[cy * gx + cx]) continue;
+
+					bool free = true;
+					for (int y = std::max(cy - 2, 0); y <= std::min(cy + 2, gy - 1) && free; ++y)
+					{
+						for (int x = std::max(cx - 2, 0); x <= std::min(cx + 2, gx - 1); ++x)
+						{
+							const vec2 d = samples[y * gx + x] - p;
+							if (occupied[y * gx + x] && glm::dot(d, d) < r2)
+							{
+								free = false;
+								break;
+							}
+						}
+					}
+					if (!free) continue;
+
+					samples[cy * gx + cx] = p;
+					occupied[cy * gx + cx] = 1;
+				}
+			}
+		}
+	}
+
+	std::vector<vec2> points;
+	for (size_t c = 0; c < samples.size(); ++c)
+	{
+		if (occupied[c]) points.push_back(samples[c]);
+	}
+	if (points.size() < PARTICLES_NUMBER)
+	{
+		std::cerr << "layout: only " << points.size() << " of " << PARTICLES_NUMBER << " particles fit at spacing "
+			<< spacing << ", lower spacing or raise fill_width" << std::endl;
+		return false;
+	}
+
+	// the lowest ones, settled at the bottom of the box
+	std::sort(points.begin(), points.end(), [](const vec2& l, const vec2& r) { return l.y < r.y || (l.y == r.y && l.x < r.x); });
+
+	#pragma omp parallel for num_threads(config.threads)
+	for (int i = 0; i < PARTICLES_NUMBER; ++i)
+	{
+		positions[i] = boxOrigin + 0.5f * spacing + points[i];
+	}
+	return true;
+}
+
+static bool fileLayout(const SceneConfig& config, vec2* positions)
+{
+	std::ifstream file(config.layoutFile);
+	if (!file)
+	{
+		std::cerr << "layout: cannot open " << config.layoutFile << std::endl;
+		return false;
+	}
+
+	std::vector<vec2> points;
+	std::string text;
+	int line = 0;
+
+	while (points.size() < PARTICLES_NUMBER && std::getline(file, text))
+	{
+		++line;
+		text = text.substr(0, text.find('#'));
+		std::replace(text.begin(), text.end(), ',', ' ');
+		if (text.find_first_not_of(" \t\r") == std::string::npos) continue;
+
+		std::istringstream values(text);
+		vec2 p;
+		if (!(values >> p.x >> p.y) || p.x < 0.0f || p.y < 0.0f || p.x > boxSize.x || p.y > boxSize.y)
+		{
+			std::cerr << config.layoutFile << ":" << line << ": expected x y inside the " << boxSize.x << " x " << boxSize.y << " box" << std::endl;
+			return false;
+		}
+		points.push_back(p);
+	}
+	if (points.size() < PARTICLES_NUMBER)
+	{
+		std::cerr << "layout: " << config.layoutFile << " has " << points.size() << " of " << PARTICLES_NUMBER << " positions" << std::endl;
+		return false;
+	}
+
+	#pragma omp parallel for num_threads(config.threads)
+	for (int i = 0; i < PARTICLES_NUMBER; ++i)
+	{
+		positions[i] = boxOrigin + points[i];
+	}
+	return true;
+}
+
+bool generateLayout(const SceneConfig& config, vec2* positions)
+{
+	const uint64_t seed = config.seed ? static_cast<uint64_t>(config.seed) : static_cast<uint64_t>(std::time(nullptr));
+	const float spacing = config.spacing > 0.0f ? config.spacing : 2.0f * radius;
+
+	if (config.layout == "grid") return latticeLayout(config, seed, spacing, false, positions);
+	if (config.layout == "hex") return latticeLayout(config, seed, spacing, true, positions);
+	if (config.layout == "poisson") return poissonLayout(config, seed, spacing, positions);
+	if (config.layout == "file") return fileLayout(config, positions);
+	return randomLayout(config, seed, positions);
+}
@@ -0,0 +1,26 @@
+#ifndef LAYOUT
+#define LAYOUT
+
+#include "scene.hpp"
+
+// Initial particle positions of the [init] section:
+//
+//     random   uniform over the box, overlapping like the original start
+//     grid     square lattice
+//     hex      hexagonal packing, rows spacing * sqrt(3) / 2 apart
+//     poisson  blue noise, no two particles closer than spacing
+//     file     x y per line in box coordinates, # starts a comment
+//
+// The lattices and poisson fill a block of fill_width times the box width
+// from the bottom left corner upwards; at the default spacing the lattice is
+// the one the IISPH rest density is measured on, so the first frames do not
+// have to push overlapping particles apart.
+//
+// Every random number is derived from the seed and the particle, tile or
+// dart index rather than drawn from a shared generator, so the generation
+// runs in parallel and a seed reproduces the same state at any thread count.
+
+// reports why a layout cannot be generated and returns false
+bool generateLayout(const SceneConfig& config, vec2* positions);
+
+#endif
@@ -0,0 +1,249 @@
+#include "scene.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+SceneConfig scene;
+
+struct SceneField
+{
+	const char* section;
+	const char* key;
+	float*       real    = nullptr;
+	int*         integer = nullptr;
+	bool*        flag    = nullptr;
+	std::string* text    = nullptr;
+};
+
+static std::vector<SceneField> sceneFields(SceneConfig& c)
+{
+	return {
+		{ "pbf", "dt",                &c.dt },
+		{ "pbf", "resistance",        &c.resistance },
+		{ "pbf", "gravity",           &c.gravity },
+		{ "pbf", "viscosity",         &c.viscosity },
+		{ "pbf", "relaxation",        &c.relaxation },
+		{ "pbf", "delta_q",           &c.deltaQ },
+		{ "pbf", "iterations",        nullptr, &c.iterations },
+		{ "pbf", "collision_penalty", &c.collisionPenalty },
+		{ "pbf", "tensile_k",         &c.tensileK },
+		{ "pbf", "tensile_n",         &c.tensileN },
+
+		{ "iisph", "dt",                &c.iisphDt },
+		{ "iisph", "cfl",               &c.cfl },
+		{ "iisph", "omega",             &c.omega },
+		{ "iisph", "xsph_viscosity",    &c.xsphViscosity },
+		{ "iisph", "max_density_error", &c.maxDensityError },
+		{ "iisph", "min_iterations",    nullptr, &c.minIterations },
+		{ "iisph", "max_iterations",    nullptr, &c.maxIterations },
+
+		{ "init", "layout",          nullptr, nullptr, nullptr, &c.layout },
+		{ "init", "layout_file",     nullptr, nullptr, nullptr, &c.layoutFile },
+		{ "init", "seed",            nullptr, &c.seed },
+		{ "init", "spacing",         &c.spacing },
+		{ "init", "fill_width",      &c.fillWidth },
+		{ "init", "jitter",          &c.jitter },
+		{ "init", "settle_frames",   nullptr, &c.settleFrames },
+		{ "init", "cache",           nullptr, nullptr, &c.cache },
+		{ "init", "cache_directory", nullptr, nullptr, nullptr, &c.cacheDirectory },
+
+		{ "run", "threads", nullptr, &c.threads },
+
+		{ "output", "trajectory",      nullptr, nullptr, &c.trajectory },
+		{ "output", "trajectory_path", nullptr, nullptr, nullptr, &c.trajectoryPath },
+		{ "output", "export",          nullptr, nullptr, nullptr, &c.exportFormat },
+		{ "output", "export_path",     nullptr, nullptr, nullptr, &c.exportPath },
+		{ "output", "export_interval", nullptr, &c.exportInterval },
+		{ "output", "live",            nullptr, nullptr, &c.live },
+		{ "output", "live_name",       nullptr, nullptr, nullptr, &c.liveName },
+	};
+}
+
+// values the build is specialised for
+struct BuildConstant
+{
+	const char* key;
+	double value;
+};
+static const BuildConstant buildConstants[] =
+{
+	{ "particles",        PARTICLES_NUMBER },
+	{ "box_width",        BOXWIDTH },
+	{ "box_height",       BOXHEIGHT },
+	{ "window_width",     WWIDTH },
+	{ "window_height",    WHEIGHT },
+	{ "scale",            scale },
+	{ "mass",             mass },
+	{ "target_density",   targetDensity },
+	{ "influence_radius", influenceRadius },
+	{ "radius",           radius },
+};
+
+static std::string trim(const std::string& text)
+{
+	const size_t first = text.find_first_not_of(" \t\r");
+	if (first == std::string::npos) return "";
+	return text.substr(first, text.find_last_not_of(" \t\r") - first + 1);
+}
+
+static bool parseValue(const SceneField& field, const std::string& value)
+{
+	char* end = nullptr;
+
+	if (field.real)
+	{
+		*field.real = std::strtof(value.c_str(), &end);
+		return end != value.c_str() && *end == '\0' && std::isfinite(*field.real);
+	}
+	if (field.integer)
+	{
+		*field.integer = static_cast<int>(std::strtol(value.c_str(), &end, 10));
+		return end != value.c_str() && *end == '\0';
+	}
+	if (field.flag)
+	{
+		if (value == "true" || value == "yes" || value == "on" || value == "1") *field.flag = true;
+		else if (value == "false" || value == "no" || value == "off" || value == "0") *field.flag = false;
+		else return false;
+		return true;
+	}
+
+	*field.text = value.size() >= 2 && value.front() == '"' && value.back() == '"' ? value.substr(1, value.size() - 2) : value;
+	return true;
+}
+
+static bool checkBuildConstant(const std::string& key, const std::string& value, std::string& error)
+{
+	for (const BuildConstant& constant : buildConstants)
+	{
+		if (key != constant.key) continue;
+
+		char* end = nullptr;
+		const double parsed = std::strtod(value.c_str(), &end);
+		if (end == value.c_str() || *end != '\0')
+		{
+			error = key + " is not a number";
+			return false;
+		}
+		if (std::abs(parsed - constant.value) > 1e-6 * std::abs(constant.value))
+		{
+			std::ostringstream message;
+			message << "the build is compiled for " << key << " = " << constant.value
+				<< ", rebuild settings.hpp with " << parsed << " to run this scene";
+			error = message.str();
+			return false;
+		}
+		return true;
+	}
+
+	error = "unknown key " + key + " in [scene]";
+	return false;
+}
+
+bool setSceneValue(SceneConfig& config, const std::string& section, const std::string& key, const std::string& value, std::string& error)
+{
+	if (section == "scene") return checkBuildConstant(key, value, error);
+
+	for (const SceneField& field : sceneFields(config))
+	{
+		if (section != field.section || key != field.key) continue;
+
+		if (parseValue(field, value)) return true;
+
+		error = "invalid value " + value + " for " + key;
+		return false;
+	}
+
+	error = "unknown key " + key + " in [" + section + "]";
+	return false;
+}
+
+bool validateScene(const SceneConfig& c, std::string& error)
+{
+	if (c.dt <= 0.0f || c.iisphDt <= 0.0f) error = "time steps have to be positive";
+	else if (c.iterations < 1) error = "pbf iterations has to be at least 1";
+	else if (c.minIterations < 1 || c.maxIterations < c.minIterations) error = "iisph iterations need 1 <= min_iterations <= max_iterations";
+	else if (c.threads < 1 || c.threads > threads) error = "run threads has to lie between 1 and the compiled thread count";
+	else if (c.deltaQ <= 0.0f || c.deltaQ >= influenceRadius) error = "delta_q has to lie inside the influence radius";
+	else if (c.layout != "random" && c.layout != "grid" && c.layout != "hex" && c.layout != "poisson" && c.layout != "file") error = "layout has to be random, grid, hex, poisson or file";
+	else if (c.layout == "file" && c.layoutFile.empty()) error = "the file layout needs layout_file";
+	else if (c.spacing < 0.0f || c.fillWidth <= 0.0f || c.fillWidth > 1.0f || c.jitter < 0.0f || c.jitter > 0.5f) error = "init needs spacing >= 0, 0 < fill_width <= 1 and 0 <= jitter <= 0.5";
+	else if (c.settleFrames < 0) error = "settle_frames cannot be negative";
+	else if (c.exportFormat != "none" && c.exportFormat != "vtk" && c.exportFormat != "ply") error = "export has to be none, vtk or ply";
+	else if (c.exportInterval < 1) error = "export_interval has to be at least 1";
+	else return true;
+
+	return false;
+}
+
+bool parseIni(const char* path, const IniEntry& entry)
+{
+	std::ifstream file(path);
+	if (!file)
+	{
+		std::cerr << "cannot open " << path << std::endl;
+		return false;
+	}
+
+	std::string section;
+	std::string text;
+	std::string error;
+	int line = 0;
+
+	while (std::getline(file, text))
+	{
+		++line;
+		text = trim(text.substr(0, text.find_first_of("#;")));
+		if (text.empty()) continue;
+
+		if (text.front() == '[')
+		{
+			if (text.back() != ']')
+			{
+				std::cerr << path << ":" << line << ": unterminated section" << std::endl;
+				return false;
+			}
+			section = trim(text.substr(1, text.size() - 2));
+			continue;
+		}
+
+		const size_t equals = text.find('=');
+		if (equals == std::string::npos)
+		{
+			std::cerr << path << ":" << line << ": expected key = value" << std::endl;
+			return false;
+		}
+
+		if (!entry(section, trim(text.substr(0, equals)), trim(text.substr(equals + 1)), error))
+		{
+			std::cerr << path << ":" << line << ": " << error << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+bool loadScene(const char* path, SceneConfig& config)
+{
+	SceneConfig parsed = config;
+
+	const bool read = parseIni(path, [&](const std::string& section, const std::string& key, const std::string& value, std::string& error)
+	{
+		return setSceneValue(parsed, section, key, value, error);
+	});
+	if (!read) return false;
+
+	std::string error;
+	if (!validateScene(parsed, error))
+	{
+		std::cerr << path << ": " << error << std::endl;
+		return false;
+	}
+
+	config = parsed;
+	return true;
+}
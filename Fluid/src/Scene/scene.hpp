@@ -0,0 +1,83 @@
+#ifndef SCENE
+#define SCENE
+
+#include "../settings.hpp"
+#include <functional>
+#include <string>
+
+// Runtime parameters of a run, read from a scene file:
+//
+//     # comments start with # or ;
+//     [pbf]
+//     viscosity = 0.05
+//     iterations = 12
+//
+// Values left out keep the defaults below. The [scene] section names the
+// quantities the build is specialised for (particle count, box, window,
+// mass, target density, influence radius); they size the static arrays and
+// the kernel policies, so a scene file may repeat them but a different value
+// is rejected with the constant to rebuild with.
+
+struct SceneConfig
+{
+	// [pbf]
+	float dt               = 0.1f;
+	float resistance       = 0.9f;
+	float gravity          = 30.0f;
+	float viscosity        = 0.04f;
+	float relaxation       = 3e-6f;
+	float deltaQ           = 0.03f;
+	int   iterations       = 20;
+	float collisionPenalty = 0.01f;
+	float tensileK         = 0.1f;
+	float tensileN         = 4.0f;
+
+	// [iisph]
+	float iisphDt         = 0.5f;
+	float cfl             = 0.4f;
+	float omega           = 0.5f;
+	float xsphViscosity   = 0.02f;
+	float maxDensityError = 0.01f;
+	int   minIterations   = 2;
+	int   maxIterations   = 50;
+
+	// [init], see layout.hpp and stateCache.hpp
+	std::string layout         = "random";	// random, grid, hex, poisson or file
+	std::string layoutFile;
+	int         seed           = 1;		// 0 seeds from the clock
+	float       spacing        = 0.0f;	// 0 is the rendering spacing 2 * radius
+	float       fillWidth      = 1.0f;	// share of the box width the block covers
+	float       jitter         = 0.0f;	// lattice displacement in spacings
+	int         settleFrames   = 0;		// frames simulated before the run starts
+	bool        cache          = true;	// keep settled states for later runs
+	std::string cacheDirectory = "cache";
+
+	// [run], at most the compiled thread count
+	int threads = ::threads;
+
+	// [output]
+	bool        trajectory     = recordTrajectory;
+	std::string trajectoryPath = "trajectory.ftr";
+	std::string exportFormat   = "none";	// none, vtk or ply
+	std::string exportPath     = "frame";	// files are <path>_<frame>.<format>
+	int         exportInterval = 10;
+	bool        live           = false;	// publish every frame to shared memory
+	std::string liveName       = "/fluid";
+};
+
+extern SceneConfig scene;
+
+// leaves config untouched and reports the offending line when the file is invalid
+bool loadScene(const char* path, SceneConfig& config);
+
+// one key of a section as it would appear in a scene file
+bool setSceneValue(SceneConfig& config, const std::string& section, const std::string& key, const std::string& value, std::string& error);
+bool validateScene(const SceneConfig& config, std::string& error);
+
+// Calls entry for every key = value line of an INI style file, text after #
+// or ; is a comment. Stops at the first malformed line or failing entry and
+// reports it with its line number.
+using IniEntry = std::function<bool(const std::string& section, const std::string& key, const std::string& value, std::string& error)>;
+bool parseIni(const char* path, const IniEntry& entry);
+
+#endif
@@ -1,6 +1,19 @@
 #include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
 #include "settings.hpp"
 #include "PBF/particles.hpp"
+#include "PBF/multirate.hpp"
+#include "IO/checkpoint.hpp"
+#include "IO/stateCache.hpp"
+#include "IO/trajectory.hpp"
+#include "IO/replay.hpp"
+#include "IO/pointCloud.hpp"
+#include "IO/livePublisher.hpp"
+#include "IO/liveReader.hpp"
+#include "Scene/scene.hpp"
+#include "Batch/sweep.hpp"
 #include "Graphics/graphics.hpp"
 
 
@@ -11,6 +24,24 @@ void MainLoop(SDL_Window*, SDL_GLContext&, GLuint&);
 // Event handler
 void Input(bool& quit);
 
+// Fluid [--scene <file>] [--replay <trajectory> | --attach <channel> | --sweep <file> | <checkpoint>]
+// a checkpoint replaces the random initial state, a replay plays a recorded
+// run back instead of simulating, attaching shows the live channel another
+// process publishes, a sweep runs headless and exits; --sweep-worker <run> is
+// how a sweep starts its runs on Windows
+static const char* restartPath = nullptr;
+static const char* replayPath = nullptr;
+static const char* attachName = nullptr;
+static const char* scenePath = nullptr;
+static const char* sweepPath = nullptr;
+static int sweepWorker = -1;
+static uint64_t frame = 0;
+
+static bool replayPlaying = true;
+static int  replayFrame = 0;
+
+static std::unique_ptr<LiveReader> liveView;
+
 
 int main(int argc, char* args[])
 {
@@ -18,6 +49,18 @@ int main(int argc, char* args[])
     SDL_GLContext context = NULL;
     GLuint gProgramID = NULL;
 
+    for (int a = 1; a < argc; ++a)
+    {
+        if (std::strcmp(args[a], "--replay") == 0 && a + 1 < argc) replayPath = args[++a];
+        else if (std::strcmp(args[a], "--scene") == 0 && a + 1 < argc) scenePath = args[++a];
+        else if (std::strcmp(args[a], "--attach") == 0 && a + 1 < argc) attachName = args[++a];
+        else if (std::strcmp(args[a], "--sweep") == 0 && a + 1 < argc) sweepPath = args[++a];
+        else if (std::strcmp(args[a], "--sweep-worker") == 0 && a + 1 < argc) sweepWorker = std::atoi(args[++a]);
+        else restartPath = args[a];
+    }
+    if (scenePath && !loadScene(scenePath, scene)) return 1;
+    if (sweepPath) return runSweep(sweepPath, sweepWorker) ? 0 : 1;
+
     Init(window, context, gProgramID);
     MainLoop(window, context, gProgramID);
     QuitSDL(window);
@@ -52,6 +95,25 @@ void Input(bool& quit)
             interactionInputStrength = 0.0;
             pressed = false;
         }
+        else if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_s && !replayPath && !liveView)
+        {
+            if (saveCheckpoint(checkpointPath, frame)) std::cout << "checkpoint saved to " << checkpointPath << " at frame " << frame << std::endl;
+        }
+        else if (e.type == SDL_KEYDOWN && replayPath)
+        {
+            // space pauses, arrows step one frame, page keys jump a hundred
+            const int last = replayFrameCount() - 1;
+            switch (e.key.keysym.sym)
+            {
+            case SDLK_SPACE:    replayPlaying = !replayPlaying; break;
+            case SDLK_RIGHT:    replayFrame = Min(replayFrame + 1, last); replayPlaying = false; break;
+            case SDLK_LEFT:     replayFrame = Max(replayFrame - 1, 0); replayPlaying = false; break;
+            case SDLK_PAGEDOWN: replayFrame = Min(replayFrame + 100, last); break;
+            case SDLK_PAGEUP:   replayFrame = Max(replayFrame - 100, 0); break;
+            case SDLK_HOME:     replayFrame = 0; break;
+            case SDLK_END:      replayFrame = last; break;
+            }
+        }
         if (e.type == SDL_MOUSEWHEEL && pressed)
         {
             interactionInputStrength += e.wheel.y * 10.0;
@@ -74,9 +136,26 @@ void MainLoop(SDL_Window* w, SDL_GLContext& context, GLuint& prog)
     GLuint gVBO, gVAO, fUBO;
     GLint blockSize;
 
-    initParticles();
+    if constexpr (tabulatedKernels) reportKernelTablesAccuracy();
+    if (replayPath && !openReplay(replayPath)) replayPath = nullptr;
+    if (attachName)
+    {
+        liveView = std::make_unique<LiveReader>(attachName);
+        if (!liveView->connected() || liveView->particles() != PARTICLES_NUMBER)
+        {
+            std::cerr << "no live channel " << attachName << " with " << PARTICLES_NUMBER << " particles" << std::endl;
+            liveView.reset();
+        }
+    }
+    const bool simulating = !replayPath && !liveView;
+
+    if (simulating && (!restartPath || !loadCheckpoint(restartPath, &frame)) && !prepareInitialState()) exit(1);
     setupViewSettingsAndData(fUBO, prog, blockSize);
 
+    if (scene.trajectory && simulating) openTrajectory(scene.trajectoryPath.c_str());
+    if (scene.exportFormat != "none" && simulating) openPointCloudExport(scene.exportFormat.c_str(), scene.exportPath.c_str());
+    if (scene.live && simulating) openLiveChannel(scene.liveName.c_str());
+
     GLint gVertexPos2DLocation = glGetAttribLocation(prog, "position");
     if (gVertexPos2DLocation == -1)
     {
@@ -105,12 +184,60 @@ void MainLoop(SDL_Window* w, SDL_GLContext& context, GLuint& prog)
         SDL_GL_SwapWindow(w);
     }
 
+    closeTrajectory();
+    closePointCloudExport();
+    closeLiveChannel();
+    closeReplay();
+    liveView.reset();
+
     glUseProgram(NULL);
 }
 void Update(GLuint& prog, GLuint& UBO, GLint& blockSize)
 {
+    if (replayPath)
+    {
+        PassUniforms(prog, UBO, blockSize, replayPositions(replayFrame));
+        glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+
+        if (replayPlaying) replayFrame = (replayFrame + 1) % replayFrameCount();
+        return;
+    }
+    if (liveView)
+    {
+        // copied out first, an upload straight from the slot could be overwritten halfway;
+        // without a complete frame the previous one stays on screen
+        static vec2 livePositions[PARTICLES_NUMBER];
+        if (liveView->copyLatest(&livePositions[0].x, nullptr)) PassUniforms(prog, UBO, blockSize, livePositions);
+        glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+        return;
+    }
+
     // Process
-    particlesUpdate();
+    stepSimulation();
+
+    // the compact grid retunes itself, only a new cell size is worth a line
+    static int compactDivisions = 0;
+    if (neighborSearch == NeighborSearch::CompactGrid && compactGrid.divisions != compactDivisions)
+    {
+        compactDivisions = compactGrid.divisions;
+        std::cout << "compact grid: cell size h/" << compactDivisions << ", "
+            << compactGrid.candidateRatio << " candidates per neighbor" << std::endl;
+    }
+
+    if (scene.trajectory) recordTrajectoryFrame(frame);
+    if (frame % scene.exportInterval == 0) exportPointCloud(frame);
+    if (scene.live) publishLiveFrame(frame);
+    ++frame;
+
+    if constexpr (multirateStepping && multirateReportInterval > 0)
+    {
+        if (frame % multirateReportInterval == 0)
+        {
+            std::cout << "multirate speedup " << multirateSpeedup() << ", particles per level";
+            for (int l = 0; l < multirateLevels; ++l) std::cout << " " << multirateStats.frameLevels[l];
+            std::cout << std::endl;
+        }
+    }
 
     // Draw
     PassUniforms(prog, UBO, blockSize);
@@ -0,0 +1,158 @@
+#ifndef KERNEL_POLICIES
+#define KERNEL_POLICIES
+
+#include "../settings.hpp"
+#include <numbers>
+#include <type_traits>
+
+// Smoothing kernels as compile-time policies. Every policy folds its
+// normalisation into constexpr coefficients and provides
+//   value(dst)         - W(r)
+//   gradientCoeff(dst) - c(r) with grad W(x_i - x_j) = c(r) * (x_i - x_j)
+//   selfValue          - W(0), which value() leaves out like KernelVersion_1
+//   singularValue      - W diverges at zero
+//   singularGradient   - |grad W| diverges or jumps at zero
+// All of them use the 3D normalisation, like KernelVersion_1, so densities
+// stay on the scale targetDensity was tuned for. The neighbor passes visit
+// the particle itself, so value(0) is 0 and a solver that wants the self
+// contribution adds selfValue.
+namespace Kernels
+{
+	constexpr scalar h  = influenceRadius;
+	constexpr scalar h2 = h * h;
+	constexpr scalar h3 = h2 * h;
+	constexpr scalar h6 = h3 * h3;
+	constexpr scalar h9 = h6 * h3;
+	constexpr scalar pi = std::numbers::pi_v<scalar>;
+
+	struct Poly6
+	{
+		static constexpr scalar valueCoeff       = 315.0f / (64.0f * pi * h9);
+		static constexpr scalar gradientScale    = -945.0f / (32.0f * pi * h9);
+		static constexpr scalar selfValue        = valueCoeff * h6;
+		static constexpr bool   singularValue    = false;
+		static constexpr bool   singularGradient = false;
+
+		static constexpr scalar value(const scalar& dst)
+		{
+			if (dst >= h || dst <= 0.0f) return 0.0f;
+			const scalar v = h2 - dst * dst;
+			return valueCoeff * v * v * v;
+		}
+		static constexpr scalar gradientCoeff(const scalar& dst)
+		{
+			if (dst >= h || dst <= 0.0f) return 0.0f;
+			const scalar v = h2 - dst * dst;
+			return gradientScale * v * v;
+		}
+	};
+	struct Spiky
+	{
+		static constexpr scalar valueCoeff       = 15.0f / (pi * h6);
+		static constexpr scalar gradientScale    = -45.0f / (pi * h6);
+		static constexpr scalar selfValue        = valueCoeff * h3;
+		static constexpr bool   singularValue    = false;
+		static constexpr bool   singularGradient = true;
+
+		static constexpr scalar value(const scalar& dst)
+		{
+			if (dst >= h || dst <= 0.0f) return 0.0f;
+			const scalar v = h - dst;
+			return valueCoeff * v * v * v;
+		}
+		static constexpr scalar gradientCoeff(const scalar& dst)
+		{
+			if (dst >= h || dst <= 0.0f) return 0.0f;
+			const scalar v = h - dst;
+			return gradientScale * v * v / dst;
+		}
+	};
+	struct CubicSpline
+	{
+		static constexpr scalar valueCoeff       = 8.0f / (pi * h3);
+		static constexpr scalar gradientScale    = 6.0f * valueCoeff / h;
+		static constexpr scalar selfValue        = valueCoeff;
+		static constexpr bool   singularValue    = false;
+		static constexpr bool   singularGradient = false;
+
+		static constexpr scalar value(const scalar& dst)
+		{
+			const scalar q = dst / h;
+			if (q >= 1.0f || q <= 0.0f) return 0.0f;
+			if (q <= 0.5f) return valueCoeff * (6.0f * (q * q * q - q * q) + 1.0f);
+
+			const scalar v = 1.0f - q;
+			return valueCoeff * 2.0f * v * v * v;
+		}
+		static constexpr scalar gradientCoeff(const scalar& dst)
+		{
+			const scalar q = dst / h;
+			if (q >= 1.0f || q <= 0.0f) return 0.0f;
+			if (q <= 0.5f) return gradientScale * (3.0f * q - 2.0f) / h;
+
+			const scalar v = 1.0f - q;
+			return -gradientScale * v * v / dst;
+		}
+	};
+	struct WendlandC2
+	{
+		static constexpr scalar valueCoeff       = 21.0f / (2.0f * pi * h3);
+		static constexpr scalar gradientScale    = -20.0f * valueCoeff / h2;
+		static constexpr scalar selfValue        = valueCoeff;
+		static constexpr bool   singularValue    = false;
+		static constexpr bool   singularGradient = false;
+
+		static constexpr scalar value(const scalar& dst)
+		{
+			const scalar q = dst / h;
+			if (q >= 1.0f || q <= 0.0f) return 0.0f;
+
+			const scalar v = 1.0f - q;
+			return valueCoeff * v * v * v * v * (1.0f + 4.0f * q);
+		}
+		static constexpr scalar gradientCoeff(const scalar& dst)
+		{
+			const scalar q = dst / h;
+			if (q >= 1.0f) return 0.0f;
+
+			const scalar v = 1.0f - q;
+			return gradientScale * v * v * v;
+		}
+	};
+	// Mueller et al. viscosity kernel, singular at zero so it has no self contribution
+	struct Viscosity
+	{
+		static constexpr scalar valueCoeff       = 15.0f / (2.0f * pi * h3);
+		static constexpr scalar selfValue        = 0.0f;
+		static constexpr bool   singularValue    = true;
+		static constexpr bool   singularGradient = true;
+
+		static constexpr scalar value(const scalar& dst)
+		{
+			if (dst >= h || dst <= 0.0f) return 0.0f;
+			return valueCoeff * (-dst * dst * dst / (2.0f * h3) + dst * dst / h2 + h / (2.0f * dst) - 1.0f);
+		}
+		static constexpr scalar gradientCoeff(const scalar& dst)
+		{
+			if (dst >= h || dst <= 0.0f) return 0.0f;
+			return valueCoeff * (-3.0f * dst / (2.0f * h3) + 2.0f / h2 - h / (2.0f * dst * dst * dst));
+		}
+	};
+
+	template <KernelType type> struct Select;
+	template <> struct Select<KernelType::Poly6>       { using type = Poly6; };
+	template <> struct Select<KernelType::Spiky>       { using type = Spiky; };
+	template <> struct Select<KernelType::CubicSpline> { using type = CubicSpline; };
+	template <> struct Select<KernelType::WendlandC2>  { using type = WendlandC2; };
+}
+
+// Kernel set a solver is instantiated with
+template <typename Density, typename Gradient, typename Viscous>
+struct KernelPolicy
+{
+	using density   = Density;
+	using gradient  = Gradient;
+	using viscosity = Viscous;
+};
+
+#endif
@@ -0,0 +1,57 @@
+#include "kernelTables.hpp"
+#include <iostream>
+
+struct KernelError
+{
+	double absolute = 0.0;
+	double relative = 0.0;
+};
+
+template <typename Tabulated, typename Analytic>
+static KernelError compare(Tabulated tabulated, Analytic analytic, const double& from)
+{
+	static constexpr int probes = 100000;
+
+	KernelError error;
+	double peak = 0.0;
+
+	for (int i = 0; i < probes; ++i)
+	{
+		const double dst = from + (influenceRadius - from) * (i + 0.5) / probes;
+		const double exact = analytic(static_cast<scalar>(dst));
+		const double diff = std::abs(tabulated(static_cast<scalar>(dst)) - exact);
+
+		peak = std::max(peak, std::abs(exact));
+		error.absolute = std::max(error.absolute, diff);
+	}
+	error.relative = (peak > 0.0) ? error.absolute / peak : 0.0;
+	return error;
+}
+static void print(const char* name, const KernelError& error)
+{
+	std::cout << "  " << name << " max abs " << error.absolute
+		<< ", max rel to peak " << error.relative << std::endl;
+}
+
+void reportKernelTablesAccuracy()
+{
+	using Poly6     = Tabulated<Kernels::Poly6>;
+	using Spiky     = Tabulated<Kernels::Spiky>;
+	using Viscosity = Tabulated<Kernels::Viscosity>;
+
+	// singular tables repeat the end point of their first interval, their errors are measured from there on
+	const double firstSample = std::sqrt(KernelTables::step);
+
+	std::cout << "kernel tables: " << KernelTables::samples << " samples over r^2, "
+		<< 2 * sizeof(KernelTables::Table) / 1024 << " KB per kernel" << std::endl;
+
+	print("poly6         ", compare(Poly6::value, KernelVersion_1::calcPoly6, 0.0));
+	print("spiky         ", compare(Spiky::value, KernelVersion_1::calcSpikyKernel, 0.0));
+	print("viscosity     ", compare(Viscosity::value, KernelVersion_1::calcViscosityKernel, firstSample));
+	print("poly6 gradient", compare(
+		[](scalar d) { return Poly6::gradientCoeff(d) * d; },
+		[](scalar d) { return KernelVersion_1::calcPoly6Gradient(vec2(d, 0.0f)).x; }, 0.0));
+	print("spiky gradient", compare(
+		[](scalar d) { return Spiky::gradientCoeff(d) * d; },
+		[](scalar d) { return KernelVersion_1::calcSpikyGradient(vec2(d, 0.0f)).x; }, firstSample));
+}
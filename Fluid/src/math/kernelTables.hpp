@@ -0,0 +1,98 @@
+#ifndef KERNEL_TABLES
+#define KERNEL_TABLES
+
+#include "kernelFunctions.hpp"
+#include "kernelPolicies.hpp"
+#include <array>
+
+// Kernel policies sampled over the squared distance in [0, influenceRadius^2]
+// and linearly interpolated. The tables are built at compile time, each one
+// is 4 KB so a solver's kernels stay in L1 during the neighbor passes.
+namespace KernelTables
+{
+	constexpr int samples = 1024;
+
+	constexpr double r2 = static_cast<double>(influenceRadius) * influenceRadius;
+
+	constexpr scalar step    = static_cast<scalar>(r2 / (samples - 1));
+	constexpr scalar invStep = static_cast<scalar>((samples - 1) / r2);
+
+	using Table = std::array<scalar, samples>;
+
+	constexpr double staticSqrt(double x)
+	{
+		if (x <= 0.0) return 0.0;
+		double v = x > 1.0 ? x : 1.0;
+		for (int i = 0; i < 64; ++i)
+		{
+			const double next = 0.5 * (v + x / v);
+			if (next >= v) break;
+			v = next;
+		}
+		return v;
+	}
+	// a function without a usable value at zero repeats the second sample there
+	template <typename F>
+	constexpr Table tabulate(F f, const bool& singular)
+	{
+		Table table{};
+		for (int i = 0; i < samples; ++i)
+		{
+			const double d2 = (i == 0 && singular ? 1 : i) * r2 / (samples - 1);
+			table[i] = static_cast<scalar>(f(static_cast<scalar>(staticSqrt(d2))));
+		}
+		return table;
+	}
+
+	inline scalar lookup(const Table& table, const scalar& d2)
+	{
+		const scalar t = d2 * invStep;
+		const int i = static_cast<int>(t);
+		if (i >= samples - 1) return table[samples - 1];
+
+		return table[i] + (table[i + 1] - table[i]) * (t - i);
+	}
+}
+
+// Tabulated version of a kernel policy. The gradient is stored as its
+// magnitude c(r) * r, which stays finite where c(r) itself diverges. The
+// value table starts at W(0) so the first interval interpolates towards the
+// peak, value() still leaves the zero distance out like the policy does.
+template <typename Kernel>
+struct Tabulated
+{
+	alignas(64) static constexpr KernelTables::Table values = KernelTables::tabulate(
+		[](scalar dst) { return dst > 0.0f ? Kernel::value(dst) : Kernel::selfValue; }, Kernel::singularValue
+	);
+	alignas(64) static constexpr KernelTables::Table gradientLengths = KernelTables::tabulate(
+		[](scalar dst) { return Kernel::gradientCoeff(dst) * dst; }, Kernel::singularGradient
+	);
+
+	static constexpr scalar selfValue = Kernel::selfValue;
+
+	static scalar value(const scalar& dst)
+	{
+		if (dst >= Kernels::h || dst <= 0.0f) return 0.0f;
+		return KernelTables::lookup(values, dst * dst);
+	}
+	static scalar gradientCoeff(const scalar& dst)
+	{
+		if (dst >= Kernels::h || dst <= 0.0f) return 0.0f;
+		return KernelTables::lookup(gradientLengths, dst * dst) / dst;
+	}
+};
+
+template <typename Kernel>
+using KernelBackend = std::conditional_t<tabulatedKernels, Tabulated<Kernel>, Kernel>;
+
+template <KernelType type>
+using SelectedKernel = KernelBackend<typename Kernels::Select<type>::type>;
+
+// kernels the PBF solver is instantiated with
+using SolverKernel = KernelPolicy<
+	SelectedKernel<densityKernel>, SelectedKernel<gradientKernel>, KernelBackend<Kernels::Viscosity>
+>;
+
+void reportKernelTablesAccuracy();
+
+#endif
@@ -29,4 +29,39 @@ static constexpr scalar targetDensity = 0.001f;
 
 static constexpr int threads = 40;
 
+enum class Solver { PBF, IISPH };
+static constexpr Solver solver = Solver::PBF;
+
+// resting particles are excluded from the PBF passes until disturbed
+static constexpr bool sleepingParticles = false;
+
+// PBF local time stepping, particles advance with dt / 2^k, k < multirateLevels
+static constexpr bool multirateStepping = false;
+static constexpr int  multirateLevels   = 3;
+// frames between the viewer's multirate reports, 0 for none
+static constexpr int  multirateReportInterval = 300;
+
+// smoothing kernels the PBF solver is compiled for
+enum class KernelType { Poly6, Spiky, CubicSpline, WendlandC2 };
+static constexpr KernelType densityKernel  = KernelType::Poly6;
+static constexpr KernelType gradientKernel = KernelType::Poly6;
+
+// interpolated lookup tables instead of the analytic kernels
+static constexpr bool tabulatedKernels = false;
+
+// Quadtree also honours per-particle smoothing lengths
+enum class NeighborSearch { Segments, CompactGrid, HashGrid, Quadtree };
+static constexpr NeighborSearch neighborSearch = NeighborSearch::Segments;
+// frames between re-tuning the compact grid cell size
+static constexpr int gridTuningInterval = 1000;
+
+// PBF passes visit each neighbor pair once over a half stencil
+static constexpr bool pairwiseEvaluation = false;
+// PBF passes run over neighbor batches gathered once per iteration
+static constexpr bool batchedGather = false;
+
+// per-frame positions and velocities are streamed to disk by an I/O thread,
+// the scene file [output] section overrides it
+static constexpr bool recordTrajectory = false;
+
 #endif
\ No newline at end of file